@@ -2,57 +2,166 @@
 #define CCHIP8_AUDIO_H_
 
 #include <SDL.h>
+#include <cchip8/spsc_queue.h>
 
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 
 #define AUDIO_SAMPLE_RATE 44100
 #define AUDIO_CHANNELS 1
-#define AUDIO_8BIT_BIAS 127
+/* Silence, for unsigned 8-bit samples */
+#define AUDIO_8BIT_BIAS 128
+/* Samples rendered at a time before they are handed to the stream */
 #define AUDIO_BUFFER_SIZE 4096
+/* One period of the tone. A power of two, so the top bits of the phase
+ * index it.
+ */
+#define AUDIO_WAVETABLE_BITS 8
+#define AUDIO_WAVETABLE_SIZE (1 << AUDIO_WAVETABLE_BITS)
+#define AUDIO_EDGE_QUEUE_SIZE 256
+/* How far the tone trails emulated time, in samples. Edges arrive once the
+ * frame they fall in has run, so this must cover a frame and its jitter.
+ */
+#define AUDIO_EDGE_DELAY (AUDIO_SAMPLE_RATE / 40)
+/* The tone's amplitude can be set up to this, the headroom of 8-bit samples */
+#define AUDIO_MAX_VOLUME 127
+/* The device buffer can be asked for between these, in sample frames */
+#define AUDIO_MIN_DEVICE_FRAMES 32
+#define AUDIO_MAX_DEVICE_FRAMES 8192
 
 namespace cchip8 {
 
+/* The tone starting or stopping, at a time counted in samples of emulated
+ * time
+ */
+struct SoundEdge {
+  uint64_t time{0};
+  bool on{false};
+};
+
+struct AudioStats {
+  uint64_t callbacks{0};
+  uint64_t samples{0};
+  /* Edges that arrived after the sample they were due at had been played,
+   * because emulation fell behind the audio device
+   */
+  uint64_t underruns{0};
+  std::chrono::nanoseconds callback_time{0};
+  std::chrono::nanoseconds callback_max{0};
+  /* Samples left in the stream after each callback, summed and at most */
+  uint64_t queued_total{0};
+  uint64_t queued_max{0};
+};
+
+/*
+ * The beeper. A wavetable holding one period of the tone is built once and
+ * read by a 32-bit phase accumulator, so a sample is a table lookup and an
+ * add.
+ *
+ * The emulation thread does not switch the tone itself. It queues the edges
+ * of the sound timer with their emulated times, and the audio callback
+ * applies each at its exact sample. Emulated time is mapped onto the
+ * callback's own count of samples with AUDIO_EDGE_DELAY of slack. The
+ * mapping is set again whenever an edge would fall well outside it, as
+ * after a pause or in turbo, when emulated time no longer keeps pace.
+ *
+ * The device is opened once and never paused. Muting and the volume are
+ * atomics the callback reads once per span it renders, so neither takes
+ * SDL's audio locks. The statistics are kept the same way.
+ */
 class Audio {
  public:
   [[nodiscard]] bool Init();
 
-  void Reset();
-  void StartTone();
-  void PauseTone();
-  bool IsPaused() const;
+  /* Silences the tone without stopping the stream, as while paused */
+  void SetMuted(const bool muted) { m_muted = muted; }
+  bool Muted() const { return m_muted; }
+
+  /* From the emulation thread. Edges must be queued in time order. */
+  void QueueEdge(uint64_t time, bool on);
 
+  /* Only before Init() */
   void setFrequency(double frequency) { m_frequency = frequency; }
-  void setVolume(double volume) { m_volume = volume; }
+  /* Asks the device for a buffer of this many sample frames, clamped to the
+   * range above, instead of the one SDL picks. Smaller buffers cut latency
+   * but need the host to run the callback on time.
+   */
+  void setBufferFrames(int frames);
+  /* The amplitude, from 0 to AUDIO_MAX_VOLUME, at any time */
+  void setVolume(int volume);
+
+  AudioStats Stats() const;
 
   void Quit();
 
  private:
   static void Callback(void *userdata, SDL_AudioStream *stream,
-                       [[maybe_unused]] int additional_amount,
-                       int total_amount) {
+                       int additional_amount,
+                       [[maybe_unused]] int total_amount) {
     auto audio = reinterpret_cast<Audio *>(userdata);
-    for (int sample = 0; sample < total_amount; ++sample) {
-      audio->m_audio_buffer.at(sample) = audio->GetSample();
-      audio->IncrementWavePosition();
+    audio->Render(stream, additional_amount);
+  }
+
+  /* Adds to a statistic that only the callback writes */
+  template <typename T>
+  static void Count(std::atomic<T> &counter, const T value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+  template <typename T>
+  static void Max(std::atomic<T> &counter, const T value) {
+    if (value > counter.load(std::memory_order_relaxed)) {
+      counter.store(value, std::memory_order_relaxed);
     }
-    SDL_PutAudioStreamData(stream, audio->m_audio_buffer.data(), total_amount);
   }
 
-  double GetSample() const;
-  void IncrementWavePosition();
+  void Render(SDL_AudioStream *stream, int samples);
+  void Fill(uint8_t *out, int samples);
+  /* Takes the next edge off the queue, if there is one, and where it falls
+   * among the callback's samples
+   */
+  bool NextEdge();
 
   const SDL_AudioSpec m_spec{
       .format = SDL_AUDIO_U8,
       .channels = AUDIO_CHANNELS,
       .freq = AUDIO_SAMPLE_RATE,
   };
-  SDL_AudioStream *m_stream;
+  SDL_AudioStream *m_stream{nullptr};
+  int m_buffer_frames{0};
 
   double m_frequency{440.0};  // A4
-  double m_volume{32.0};
-  double m_wave_pos{0.0};
+  std::atomic<bool> m_muted{false};
+  std::atomic<int> m_volume{32};
+
+  /* Everything below belongs to the audio callback once it runs */
+  /* One period at full scale, scaled by the volume as it is read */
+  std::array<int8_t, AUDIO_WAVETABLE_SIZE> m_wavetable{};
+  uint32_t m_phase{0};
+  uint32_t m_increment{0};
+  bool m_gate{false};
+  /* Samples rendered so far, and emulated time minus that where edges are
+   * placed
+   */
+  uint64_t m_sample{0};
+  int64_t m_offset{0};
+  bool m_synced{false};
+  SoundEdge m_edge{};
+  bool m_has_edge{false};
+  uint64_t m_edge_sample{0};
+  SpscQueue<SoundEdge, AUDIO_EDGE_QUEUE_SIZE> m_edges{};
+
+  std::array<uint8_t, AUDIO_BUFFER_SIZE> m_audio_buffer{};
 
-  std::array<uint8_t, AUDIO_BUFFER_SIZE> m_audio_buffer;
+  std::atomic<uint64_t> m_callbacks{0};
+  std::atomic<uint64_t> m_samples{0};
+  std::atomic<uint64_t> m_underruns{0};
+  std::atomic<int64_t> m_callback_ns{0};
+  std::atomic<int64_t> m_callback_max_ns{0};
+  std::atomic<uint64_t> m_queued_total{0};
+  std::atomic<uint64_t> m_queued_max{0};
 };
 
 }  // namespace cchip8
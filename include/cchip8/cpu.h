@@ -5,6 +5,8 @@
 #include <cchip8/input.h>
 #include <cchip8/instruction.h>
 #include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/random.h>
 
 #include <array>
 
@@ -31,6 +33,32 @@ enum Registers {
   VF,
 };
 
+enum class FaultKind {
+  None,
+  /* pc does not point at a whole instruction in RAM */
+  Fetch,
+  /* An instruction accessed RAM past its end */
+  Ram,
+  /* CALL with the stack full */
+  StackOverflow,
+  /* RET with the stack empty */
+  StackUnderflow,
+};
+
+/*
+ * Raised by the checked memory policy in place of a host exception. pc is
+ * the faulting instruction's address and `address` the RAM address or stack
+ * index it tried to access.
+ */
+struct GuestFault {
+  FaultKind kind{FaultKind::None};
+  uint16_t pc{0};
+  uint16_t opcode{0};
+  uint16_t address{0};
+};
+
+const char *FaultName(const FaultKind kind);
+
 class Cpu {
  public:
   std::array<uint8_t, NUM_REGISTERS> registers{};
@@ -48,44 +76,106 @@ class Cpu {
   /* Sound timer register */
   uint8_t t_sound{0};
 
+  /* RND draws from `rng`, which Reset() restarts from `seed`, so a run is
+   * reproducible from its seed and the state travels with the Cpu
+   */
+  uint64_t seed{DEFAULT_SEED};
+  RandomState rng{SeedRandom(DEFAULT_SEED)};
+
+  /* The first fault raised since Reset(). Execution stops once it is set,
+   * leaving pc at the faulting instruction.
+   */
+  GuestFault fault{};
+
+  /* Waiting in Fx0A for a key to be released. The timers keep running but
+   * no instruction does.
+   */
+  bool halted{false};
+  /* Stopped for good by 00FD, with pc left on it */
+  bool exited{false};
+
   void Reset();
-  uint8_t RandomByte() const;
+  /* Compares everything an instruction can change but memory */
+  bool SameState(const Cpu &other) const;
+  void Seed(const uint64_t value);
+  uint8_t RandomByte();
 
+  /* Always false with the fast memory policy, so that the check compiles
+   * away
+   */
+  bool Faulted() const {
+    return MemoryPolicy::checked && fault.kind != FaultKind::None;
+  }
+  /* Halted, exited or faulted, so Tick() has nothing to do */
+  bool Stopped() const { return halted || exited || Faulted(); }
+  void RaiseFault(const FaultKind kind, const uint16_t opcode,
+                  const uint16_t address);
+  void Skip(const Memory &memory);
+
+  /* The instructions taking a Quirks profile are instantiated for each one
+   * in cpu.cpp
+   */
   void CLS(Memory &memory);
   void RET(Memory &memory);
+  void SCD(const Instruction &instruction, Memory &memory);
+  void SCU(const Instruction &instruction, Memory &memory);
+  void SCR(Memory &memory);
+  void SCL(Memory &memory);
+  void EXIT();
+  void LOW(Memory &memory);
+  void HIGH(Memory &memory);
   void SYS();
   void JP(const Instruction &instruction);
   void CALL(const Instruction &instruction, Memory &memory);
-  void SE_VX_KK(const Instruction &instruction);
-  void SNE_VX_KK(const Instruction &instruction);
-  void SE_VX_VY(const Instruction &instruction);
+  void SE_VX_KK(const Instruction &instruction, const Memory &memory);
+  void SNE_VX_KK(const Instruction &instruction, const Memory &memory);
+  void SE_VX_VY(const Instruction &instruction, const Memory &memory);
+  void LD_I_VX_VY(const Instruction &instruction, Memory &memory);
+  void LD_VX_VY_I(const Instruction &instruction, Memory &memory);
   void LD_VX_KK(const Instruction &instruction);
   void ADD_VX_KK(const Instruction &instruction);
   void LD_VX_VY(const Instruction &instruction);
+  template <typename Quirks>
   void OR_VX_VY(const Instruction &instruction);
+  template <typename Quirks>
   void AND_VX_VY(const Instruction &instruction);
+  template <typename Quirks>
   void XOR_VX_VY(const Instruction &instruction);
   void ADD_VX_VY(const Instruction &instruction);
   void SUB_VX_VY(const Instruction &instruction);
+  template <typename Quirks>
   void SHR_VX(const Instruction &instruction);
   void SUBN_VX_VY(const Instruction &instruction);
+  template <typename Quirks>
   void SHL_VX(const Instruction &instruction);
-  void SNE_VX_VY(const Instruction &instruction);
+  void SNE_VX_VY(const Instruction &instruction, const Memory &memory);
   void LD_I(const Instruction &instruction);
+  template <typename Quirks>
   void JP_V0(const Instruction &instruction);
   void RND_VX_KK(const Instruction &instruction);
+  template <typename Quirks>
   void DRW_VX_VY(const Instruction &instruction, Memory &memory);
-  void SKP_VX(const Instruction &instruction, Input &input);
-  void SKNP_VX(const Instruction &instruction, Input &input);
+  void SKP_VX(const Instruction &instruction, const Memory &memory,
+              Input &input);
+  void SKNP_VX(const Instruction &instruction, const Memory &memory,
+               Input &input);
+  void LD_I_LONG(const Memory &memory);
+  void PLANE(const Instruction &instruction, Memory &memory);
   void LD_VX_DT(const Instruction &instruction);
-  void LD_VX_K(const Instruction &instruction, Input &input);
+  void LD_VX_K(Input &input);
   void LD_DT_VX(const Instruction &instruction);
   void LD_ST_VX(const Instruction &instruction);
   void ADD_I_VX(const Instruction &instruction);
   void LD_F_VX(const Instruction &instruction);
+  void LD_HF_VX(const Instruction &instruction);
+  template <typename Quirks>
   void LD_B_VX(const Instruction &instruction, Memory &memory);
+  template <typename Quirks>
   void LD_I_VX(const Instruction &instruction, Memory &memory);
+  template <typename Quirks>
   void LD_VX_I(const Instruction &instruction, Memory &memory);
+  void LD_R_VX(const Instruction &instruction, Memory &memory);
+  void LD_VX_R(const Instruction &instruction, Memory &memory);
   void UNKNOWN(const Instruction &instruction);
 };
 
@@ -0,0 +1,28 @@
+#ifndef CCHIP8_DISPATCH_H_
+#define CCHIP8_DISPATCH_H_
+
+#include <cchip8/instruction.h>
+
+#include <array>
+#include <cstdint>
+
+#define NUM_INSTRUCTION_WORDS 0x10000
+
+namespace cchip8 {
+
+class Machine;
+
+using Handler = void (*)(Machine& machine, const Instruction& instruction);
+
+/* Every raw 16-bit instruction word mapped straight to the handler that
+ * executes it under a quirks profile. Built at compile time for each profile
+ * in quirks.h and checked against Instruction::Decode() for all 65536 words.
+ */
+template <typename Quirks>
+struct Dispatch {
+  static const std::array<Handler, NUM_INSTRUCTION_WORDS> HANDLERS;
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_DISPATCH_H_
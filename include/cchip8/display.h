@@ -3,23 +3,41 @@
 
 #include <SDL.h>
 
+#include <cstdint>
+#include <vector>
+
 #define DISPLAY_HEIGHT 32
 #define DISPLAY_WIDTH 64
-#define DISPLAY_SIZE (DISPLAY_HEIGHT * DISPLAY_WIDTH)
-#define DISPLAY_SCALE 10
 
 namespace cchip8 {
 
+class Framebuffer;
+
+/*
+ * Draws the framebuffer through one streaming texture, sized for high
+ * resolution. The rows that changed are expanded into it and uploaded, and
+ * the texture is drawn with a single call, scaled by the largest whole
+ * number that fits and centred, with nearest sampling so pixels stay square
+ * and sharp.
+ */
 class Display {
  public:
-  void Init(const float pos_x, const float pos_y, SDL_Renderer* renderer);
-  void DrawPixel(const float x, const float y);
+  [[nodiscard]] bool Init(SDL_Renderer* renderer);
+  void Quit();
+  /* Brings the given rows of the texture up to date, bit y for row y */
+  void Update(const Framebuffer& vram, uint64_t rows);
+  /* Draws the texture into an output of `width` by `height` pixels */
+  void Draw(int width, int height);
   void HandleEvent(const SDL_Event& event);
 
  private:
-  float m_pos_x{0.0};
-  float m_pos_y{0.0};
   SDL_Renderer* m_renderer = nullptr;
+  SDL_Texture* m_texture = nullptr;
+  /* XRGB8888 pixels, a high resolution row apart */
+  std::vector<uint32_t> m_pixels{};
+  /* The resolution of the framebuffer last uploaded */
+  int m_columns{DISPLAY_WIDTH};
+  int m_rows{DISPLAY_HEIGHT};
 };
 
 }  // namespace cchip8
@@ -2,58 +2,210 @@
 #define CCHIP8_EMULATOR_H_
 
 #include <cchip8/audio.h>
-#include <cchip8/cpu.h>
 #include <cchip8/input.h>
-#include <cchip8/instruction.h>
-#include <cchip8/memory.h>
+#include <cchip8/latency.h>
+#include <cchip8/machine.h>
+#include <cchip8/movie.h>
+#include <cchip8/rewind.h>
 #include <cchip8/rom.h>
+#include <cchip8/savestate.h>
+#include <cchip8/scheduler.h>
+#include <cchip8/spsc_queue.h>
+#include <cchip8/triple_buffer.h>
 #include <cchip8/window.h>
 
-#define TICKS_PER_FRAME 10
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/* In turbo mode, frames run back to back and only every Nth one is drawn */
+#define TURBO_DRAW_INTERVAL 10
+#define THROUGHPUT_REPORT_INTERVAL_MS 1000
+/* Events waiting for the emulation thread. It takes them every frame, so
+ * this is far more than a human can type in one.
+ */
+#define EVENT_QUEUE_SIZE 256
 
 namespace cchip8 {
 
+/* A finished frame, handed from the emulation thread to the renderer */
+struct FrameSnapshot {
+  Framebuffer vram{};
+  /* The rows that differ from the frame published before this one */
+  uint64_t rows{ALL_ROWS};
+  /* Counts published frames from 1, so the renderer can tell whether it
+   * missed any in between
+   */
+  uint64_t sequence{0};
+  /* When the earliest keypad press in the run of frames that ended with
+   * this one was made, in SDL nanoseconds, or 0
+   */
+  uint64_t pressed{0};
+};
+
+/*
+ * Runs the machine on a thread of its own, paced by the frame scheduler,
+ * while the thread that called Start() pumps SDL events, renders and
+ * presents. The two only meet through lock-free structures: key events and
+ * the pause menu's commands go to the emulation thread through a ring, and
+ * finished frames come back through a triple buffer. A present that stalls
+ * on vsync or the compositor therefore never delays instructions or
+ * timers, and slow emulation never holds up the window.
+ *
+ * Everything about the machine, the movie, rewind, save states and the
+ * tone belongs to the emulation thread once it has started.
+ */
 class Emulator {
  public:
   ~Emulator();
 
   bool LoadRom(const Rom& rom);
+  [[nodiscard]] bool SetBackend(const Backend backend) {
+    return m_machine.SetBackend(backend);
+  }
+  /* Seeds RND with the same value on every load and reset, instead of a
+   * fresh random one
+   */
+  void SetSeed(const uint64_t seed) { m_seed = seed; }
+  void SetIdleSkip(const bool enabled) { m_machine.SetIdleSkip(enabled); }
+  void SetQuirks(const Quirks quirks) { m_machine.SetQuirks(quirks); }
+  /* Instructions run per 60 Hz frame, clamped to the range above */
+  void SetTicksPerFrame(int ticks);
+  /* Runs frames as fast as the host allows instead of at 60 Hz. The timers
+   * still count down once per emulated frame.
+   */
+  void SetTurbo(bool enabled);
+  /* Writes the state to the ROM's .autosave file after every frame, and
+   * resumes from it on start when it holds a state for the same ROM
+   */
+  void SetAutosave(const bool enabled) { m_autosave_enabled = enabled; }
+  /* Records the keypad of every frame, with the seed and settings, to a
+   * movie written on exit
+   */
+  void Record(const std::string& filename) { m_record_file = filename; }
+  /* Drives the keypad from a movie instead of the keyboard, and stops at
+   * its end
+   */
+  [[nodiscard]] bool Play(const std::string& filename);
+  /* The audio device's buffer, in sample frames */
+  void SetAudioBuffer(const int frames) { m_audio.setBufferFrames(frames); }
+  /* The most frames run back to back to make up for late ones */
+  void SetMaxCatchUp(const int frames) { m_scheduler.SetMaxCatchUp(frames); }
   [[nodiscard]] bool RomLoaded() { return m_rom_loaded; };
   void Start();
-  void Reset();
-  void Pause();
-  void UnPause(bool resume_audio);
 
  private:
   bool m_rom_loaded{false};
-  bool m_running{false};
+  /* Cleared by either thread to stop both */
+  std::atomic<bool> m_running{false};
 
+  /* Whether the emulation thread is holding the machine still, and whether
+   * the pause menu is open on the other one
+   */
   bool m_paused{false};
-  bool m_reset{false};
+  bool m_menu_open{false};
+
+  int m_ticks_per_frame{TICKS_PER_FRAME};
+  bool m_turbo{false};
+  /* Set while the rewind key is held */
+  bool m_rewinding{false};
+  /* The machine's fault has been logged and the menu opened for it, which
+   * is not done again until something replaces the faulted machine
+   */
+  bool m_fault_reported{false};
+
+  /* Where the last throughput report left off */
+  FrameScheduler::Clock::time_point m_report_time{};
+  uint64_t m_report_ticks{0};
+  uint64_t m_report_frames{0};
+  uint64_t m_frames{0};
+  /* Frames not published because the display had not changed since the
+   * last one that was, on the emulation thread
+   */
+  uint64_t m_frames_unchanged{0};
+  uint64_t m_published_hash{0};
+  uint64_t m_frames_published{0};
+  /* Frames drawn, and frames replaced by a newer one before they could be,
+   * on the rendering thread
+   */
+  uint64_t m_frames_presented{0};
+  uint64_t m_frames_superseded{0};
+  uint64_t m_presented_sequence{0};
 
-  bool m_draw{false};
+  SpscQueue<SDL_Event, EVENT_QUEUE_SIZE> m_events{};
+  /* Key events for the machine that arrived since frames last ran */
+  std::vector<SDL_Event> m_key_events{};
+  /* The earliest press for the frames about to run, handed over with the
+   * frame they publish, if any
+   */
+  uint64_t m_pressed{0};
+  /* On the rendering thread */
+  LatencyProbe m_latency{};
+  TripleBuffer<FrameSnapshot> m_snapshots{};
 
+  bool m_autosave_enabled{false};
+
+  /* Whether the last edge queued started the tone */
+  bool m_tone{false};
+
+  Movie m_movie{};
+  std::string m_record_file{};
+  bool m_playing{false};
+  size_t m_movie_frame{0};
+  /* The keyboard while a movie records or plays, which only reaches the
+   * machine once per frame through the movie
+   */
+  Input m_keypad{};
+
+  std::optional<uint64_t> m_seed{};
   Rom m_rom{};
-  Cpu m_cpu{};
-  Memory m_memory{};
-  Input m_input{};
+  uint64_t m_rom_hash{0};
+  Machine m_machine{};
   Audio m_audio{};
   Window m_window{};
+  FrameScheduler m_scheduler{};
+  Rewind m_rewind{};
+  Autosave m_autosave{};
   SDL_Event m_event{};
 
   bool InitDevices();
+  void Seed();
+  void Reset();
   void MainLoop();
-  void UpdateTimers();
-  void UpdateSound();
+  void QueueSound();
+  void SilenceTone();
+  void OpenAutosave();
+  bool Recording() const { return !m_record_file.empty(); }
+  bool MovieActive() const { return m_playing || Recording(); }
+  /* Whether a key that would break a movie's replay has to be ignored */
+  bool LockedByMovie() const;
+  bool FeedKeys();
+  /* Save states are kept next to the ROM as rom.ch8.state1 and so on */
+  std::string SlotFilename(int slot) const;
+  void SaveSlot(int slot);
+  void LoadSlot(int slot);
 
+  /* On the thread that called Start() */
   void PollEvents();
-  void HandleEvent(const SDL_Event& event);
+  /* Hands an event to the emulation thread */
+  void Send(const SDL_Event& event);
+  void Send(Uint32 type);
+  void Pause();
   void PollPauseEvents();
   void HandlePauseEvent(const SDL_Event& event);
+  /* Draws the newest frame, returning false if there was nothing to do */
+  bool Present();
 
-  Instruction Fetch();
-  void Update();
-  void Tick();
+  /* On the emulation thread */
+  void EmulationLoop();
+  void ReceiveEvents();
+  void HandleEvent(const SDL_Event& event);
+  void QueueKeys(int frames);
+  void Update(int frames);
+  void Publish(bool whole);
+  void ReportThroughput(bool force);
 };
 
 }  // namespace cchip8
@@ -5,7 +5,8 @@
 
 #define SDL_RESUME_GAME SDL_EVENT_USER + 1
 #define SDL_RESET_GAME SDL_EVENT_USER + 2
+#define SDL_PAUSE_GAME SDL_EVENT_USER + 3
 
-#define NUM_CUSTOM_EVENTS 2
+#define NUM_CUSTOM_EVENTS 3
 
 #endif  // CCHIP8_EVENTS_H_
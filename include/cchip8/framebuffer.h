@@ -0,0 +1,173 @@
+#ifndef CCHIP8_FRAMEBUFFER_H_
+#define CCHIP8_FRAMEBUFFER_H_
+
+#include <cchip8/display.h>
+
+#include <array>
+#include <cstdint>
+
+/* The SUPER-CHIP high resolution. Low resolution is DISPLAY_WIDTH by
+ * DISPLAY_HEIGHT.
+ */
+#define HIRES_WIDTH 128
+#define HIRES_HEIGHT 64
+#define ROW_WORD_BITS 64
+#define ROW_WORDS (HIRES_WIDTH / ROW_WORD_BITS)
+/* XO-CHIP's bit planes. A pixel's colour is its bit from each plane. */
+#define NUM_PLANES 2
+#define NUM_COLORS (1 << NUM_PLANES)
+/* Every row, as a mask of one bit a row */
+#define ALL_ROWS (~uint64_t{0})
+
+namespace cchip8 {
+
+constexpr uint64_t RotateRight(const uint64_t bits, const int n) {
+  return (bits >> (n & 63)) | (bits << ((ROW_WORD_BITS - n) & 63));
+}
+
+/* Counts the zero bits above the highest set one, 64 for zero */
+inline int LeadingZeros(const uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+  return bits == 0 ? ROW_WORD_BITS : __builtin_clzll(bits);
+#else
+  auto zeros = 0;
+  while (zeros < ROW_WORD_BITS && ((bits << zeros) >> 63) == 0) ++zeros;
+  return zeros;
+#endif
+}
+
+/*
+ * A row of pixels packed into words. Pixel x is bit 63 - (x % 64) of word
+ * x / 64, so a row reads left to right like a sprite byte does. In low
+ * resolution only the first word is used and the second stays clear.
+ */
+using FrameRow = std::array<uint64_t, ROW_WORDS>;
+using Plane = std::array<FrameRow, HIRES_HEIGHT>;
+
+/*
+ * The display, one bit per pixel in each plane. The rows are always sized
+ * for high resolution and the low resolution screen is their top left
+ * corner, so switching mode never reallocates. Clearing is a fill over the
+ * rows and scrolling moves whole rows or shifts words, never single pixels.
+ *
+ * Drawing, clearing and scrolling apply to the planes selected by Fn01, one
+ * plane after the other. The planes are only combined into colours when the
+ * frame is read.
+ *
+ * Every change marks the rows it touched in a dirty mask, bit y for row y,
+ * which the renderer takes once per frame so it only has to look at those
+ * rows. A row that was drawn to and then XORed back is still marked, so the
+ * content hash is kept as well, computed on demand and cached until the
+ * next change, for telling whether the frame differs at all.
+ */
+class Framebuffer {
+ public:
+  std::array<Plane, NUM_PLANES> planes{};
+  /* Bit p is set when plane p is selected. CHIP-8 and SUPER-CHIP programs
+   * never change it and only ever see the first plane.
+   */
+  uint8_t selected{1};
+  bool hires{false};
+
+  int Width() const { return hires ? HIRES_WIDTH : DISPLAY_WIDTH; }
+  int Height() const { return hires ? HIRES_HEIGHT : DISPLAY_HEIGHT; }
+  bool Selected(const int plane) const {
+    return ((selected >> plane) & 1) != 0;
+  }
+
+  /* The colour of a pixel, 0 for off and 1 for lit in the first plane */
+  uint8_t Pixel(const int x, const int y) const {
+    const auto word = x / ROW_WORD_BITS;
+    const auto shift = ROW_WORD_BITS - 1 - (x % ROW_WORD_BITS);
+    uint8_t color = 0;
+    for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+      color |= ((planes[plane][y][word] >> shift) & 1) << plane;
+    }
+    return color;
+  }
+
+  /* The number of pixels from (x, y) rightwards that share its colour, which
+   * is stored in `color`. Whole words of equal pixels are skipped at once.
+   */
+  int Span(const int x, const int y, uint8_t& color) const;
+
+  void Clear() {
+    for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+      if (Selected(plane)) planes[plane].fill(FrameRow{});
+    }
+    Touch(ALL_ROWS);
+  }
+  /* Changing resolution clears every plane */
+  void SetHires(const bool enabled) {
+    hires = enabled;
+    planes.fill(Plane{});
+    Touch(ALL_ROWS);
+  }
+
+  /* Marks rows as changed. Code that writes `planes` directly, as loading a
+   * state does, must call this.
+   */
+  void Touch(const uint64_t rows) {
+    m_dirty |= rows;
+    m_hash_valid = false;
+  }
+  /* The rows changed since the last call, forgetting them */
+  uint64_t TakeDirty() {
+    const auto rows = m_dirty;
+    m_dirty = 0;
+    return rows;
+  }
+
+  /* XORs a sprite row onto row y of a plane with its leftmost pixel at
+   * column x. The sprite's pixels are the top bits of `bits`, at most 16 of
+   * them. Pixels past the right edge wrap to the left one, or are dropped
+   * when `clip` is set. Returns whether any lit pixel was turned off.
+   */
+  bool XorRow(const int plane, const int y, const int x, const uint64_t bits,
+              const bool clip) {
+    const auto sprite = Place(bits, x, clip);
+    auto& row = planes[plane][y];
+    uint64_t erased = 0;
+    uint64_t drawn = 0;
+    for (auto word = 0; word < ROW_WORDS; ++word) {
+      erased |= row[word] & sprite[word];
+      drawn |= sprite[word];
+      row[word] ^= sprite[word];
+    }
+    if (drawn != 0) Touch(uint64_t{1} << y);
+    return erased != 0;
+  }
+
+  void ScrollDown(const int n);
+  void ScrollUp(const int n);
+  void ScrollRight(const int n);
+  void ScrollLeft(const int n);
+
+  /* FNV-1a over the visible rows of each plane and the resolution */
+  uint64_t Hash() const;
+
+ private:
+  /* A new framebuffer has never been drawn, so all of it is dirty */
+  uint64_t m_dirty{ALL_ROWS};
+  mutable uint64_t m_hash{0};
+  mutable bool m_hash_valid{false};
+
+
+  FrameRow Place(const uint64_t bits, const int x, const bool clip) const {
+    /* A low resolution row is a single word, which a rotate wraps */
+    if (!hires) return {clip ? bits >> x : RotateRight(bits, x), 0};
+    if (x < ROW_WORD_BITS) {
+      /* A sprite is at most 16 pixels wide, so it cannot reach the right
+       * edge from here
+       */
+      return {bits >> x, x == 0 ? 0 : bits << (ROW_WORD_BITS - x)};
+    }
+    const auto wrapped =
+        clip || x == ROW_WORD_BITS ? 0 : bits << (HIRES_WIDTH - x);
+    return {wrapped, bits >> (x - ROW_WORD_BITS)};
+  }
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_FRAMEBUFFER_H_
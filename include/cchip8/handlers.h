@@ -0,0 +1,174 @@
+#ifndef CCHIP8_HANDLERS_H_
+#define CCHIP8_HANDLERS_H_
+
+#include <cchip8/instruction.h>
+#include <cchip8/machine.h>
+
+namespace cchip8 {
+
+/*
+ * Each handler forwards to the Cpu, passing along whichever parts of the
+ * machine the instruction touches. They are inline so that the dispatch
+ * table and the fused superblock operations can both use them. Those for
+ * instructions that depend on the quirks profile take it as a template
+ * parameter.
+ */
+inline void ExecCLS(Machine &m, const Instruction &) {
+  m.draw = true;
+  m.cpu.CLS(m.memory);
+}
+inline void ExecRET(Machine &m, const Instruction &) { m.cpu.RET(m.memory); }
+inline void ExecSCD(Machine &m, const Instruction &i) {
+  m.draw = true;
+  m.cpu.SCD(i, m.memory);
+}
+inline void ExecSCU(Machine &m, const Instruction &i) {
+  m.draw = true;
+  m.cpu.SCU(i, m.memory);
+}
+inline void ExecSCR(Machine &m, const Instruction &) {
+  m.draw = true;
+  m.cpu.SCR(m.memory);
+}
+inline void ExecSCL(Machine &m, const Instruction &) {
+  m.draw = true;
+  m.cpu.SCL(m.memory);
+}
+inline void ExecEXIT(Machine &m, const Instruction &) { m.cpu.EXIT(); }
+inline void ExecLOW(Machine &m, const Instruction &) {
+  m.draw = true;
+  m.cpu.LOW(m.memory);
+}
+inline void ExecHIGH(Machine &m, const Instruction &) {
+  m.draw = true;
+  m.cpu.HIGH(m.memory);
+}
+inline void ExecSYS(Machine &m, const Instruction &) { m.cpu.SYS(); }
+inline void ExecJP(Machine &m, const Instruction &i) { m.cpu.JP(i); }
+inline void ExecCALL(Machine &m, const Instruction &i) {
+  m.cpu.CALL(i, m.memory);
+}
+inline void ExecSE_VX_KK(Machine &m, const Instruction &i) {
+  m.cpu.SE_VX_KK(i, m.memory);
+}
+inline void ExecSNE_VX_KK(Machine &m, const Instruction &i) {
+  m.cpu.SNE_VX_KK(i, m.memory);
+}
+inline void ExecSE_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.SE_VX_VY(i, m.memory);
+}
+inline void ExecLD_I_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.LD_I_VX_VY(i, m.memory);
+}
+inline void ExecLD_VX_VY_I(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_VY_I(i, m.memory);
+}
+inline void ExecLD_VX_KK(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_KK(i);
+}
+inline void ExecADD_VX_KK(Machine &m, const Instruction &i) {
+  m.cpu.ADD_VX_KK(i);
+}
+inline void ExecLD_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_VY(i);
+}
+template <typename Quirks>
+inline void ExecOR_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.OR_VX_VY<Quirks>(i);
+}
+template <typename Quirks>
+inline void ExecAND_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.AND_VX_VY<Quirks>(i);
+}
+template <typename Quirks>
+inline void ExecXOR_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.XOR_VX_VY<Quirks>(i);
+}
+inline void ExecADD_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.ADD_VX_VY(i);
+}
+inline void ExecSUB_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.SUB_VX_VY(i);
+}
+template <typename Quirks>
+inline void ExecSHR_VX(Machine &m, const Instruction &i) {
+  m.cpu.SHR_VX<Quirks>(i);
+}
+inline void ExecSUBN_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.SUBN_VX_VY(i);
+}
+template <typename Quirks>
+inline void ExecSHL_VX(Machine &m, const Instruction &i) {
+  m.cpu.SHL_VX<Quirks>(i);
+}
+inline void ExecSNE_VX_VY(Machine &m, const Instruction &i) {
+  m.cpu.SNE_VX_VY(i, m.memory);
+}
+inline void ExecLD_I(Machine &m, const Instruction &i) { m.cpu.LD_I(i); }
+template <typename Quirks>
+inline void ExecJP_V0(Machine &m, const Instruction &i) {
+  m.cpu.JP_V0<Quirks>(i);
+}
+inline void ExecRND_VX_KK(Machine &m, const Instruction &i) {
+  m.cpu.RND_VX_KK(i);
+}
+template <typename Quirks>
+inline void ExecDRW_VX_VY(Machine &m, const Instruction &i) {
+  m.draw = true;
+  m.cpu.DRW_VX_VY<Quirks>(i, m.memory);
+}
+inline void ExecSKP_VX(Machine &m, const Instruction &i) {
+  m.cpu.SKP_VX(i, m.memory, m.input);
+}
+inline void ExecSKNP_VX(Machine &m, const Instruction &i) {
+  m.cpu.SKNP_VX(i, m.memory, m.input);
+}
+inline void ExecLD_I_LONG(Machine &m, const Instruction &) {
+  m.cpu.LD_I_LONG(m.memory);
+}
+inline void ExecPLANE(Machine &m, const Instruction &i) {
+  m.cpu.PLANE(i, m.memory);
+}
+inline void ExecLD_VX_DT(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_DT(i);
+}
+inline void ExecLD_VX_K(Machine &m, const Instruction &) {
+  m.cpu.LD_VX_K(m.input);
+}
+inline void ExecLD_DT_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_DT_VX(i);
+}
+inline void ExecLD_ST_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_ST_VX(i);
+}
+inline void ExecADD_I_VX(Machine &m, const Instruction &i) {
+  m.cpu.ADD_I_VX(i);
+}
+inline void ExecLD_F_VX(Machine &m, const Instruction &i) { m.cpu.LD_F_VX(i); }
+inline void ExecLD_HF_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_HF_VX(i);
+}
+template <typename Quirks>
+inline void ExecLD_B_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_B_VX<Quirks>(i, m.memory);
+}
+template <typename Quirks>
+inline void ExecLD_I_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_I_VX<Quirks>(i, m.memory);
+}
+template <typename Quirks>
+inline void ExecLD_VX_I(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_I<Quirks>(i, m.memory);
+}
+inline void ExecLD_R_VX(Machine &m, const Instruction &i) {
+  m.cpu.LD_R_VX(i, m.memory);
+}
+inline void ExecLD_VX_R(Machine &m, const Instruction &i) {
+  m.cpu.LD_VX_R(i, m.memory);
+}
+/* Unknown instructions are treated as NOPs */
+inline void ExecUNKNOWN(Machine &, const Instruction &) {}
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_HANDLERS_H_
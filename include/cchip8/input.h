@@ -4,23 +4,82 @@
 #include <SDL.h>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 
 #define NUM_KEYS 16
-#define KEYBOARD_SIZE 255
+/* Key changes that can wait to be applied part way through a frame. Past
+ * this many, the oldest is applied at once to make room.
+ */
+#define INPUT_QUEUE_SIZE 64
 
 namespace cchip8 {
 
+/* A keypad key going down or up at a slice of a frame. Slices past the end
+ * of the frame fall in the frames after it.
+ */
+struct KeyChange {
+  int slice{0};
+  uint8_t key{0};
+  bool down{false};
+};
+
+/*
+ * The keypad, as one bit per key. Changes are either applied as their
+ * events arrive, or queued with the slice of the frame they belong at and
+ * applied by the machine between the slices it runs, so a key pressed a
+ * quarter of the way into a frame is seen a quarter of the way into its
+ * instructions.
+ */
 class Input {
  public:
   void Reset();
-  bool IsDown(uint8_t key) const;
-  bool IsUp(uint8_t key) const;
+  bool IsDown(uint8_t key) const {
+    return key < NUM_KEYS && ((m_down >> key) & 1) != 0;
+  }
+  bool IsUp(uint8_t key) const { return !IsDown(key); }
   void HandleEvent(const SDL_Event &event);
 
+  /* Queues a key event to be applied at a slice instead of now */
+  void QueueEvent(const SDL_Event &event, int slice);
+  /* Applies the queued changes due by the start of the slice */
+  void ApplyQueued(int slice);
+  /* Moves what is still queued on by a frame of this many slices */
+  void EndFrame(int slices);
+
+  /* Starts waiting for Fx0A: keys down now or pressed from now on count,
+   * and the first of them to be released is reported by TakeRelease()
+   */
+  void WaitForKey();
+  bool TakeRelease(uint8_t &key);
+
+  /* The keypad as a mask, bit k for key k */
+  uint16_t Keys() const { return m_down; }
+  /* Presses and releases keys so that exactly those in the mask are down,
+   * as the matching key events would
+   */
+  void SetKeys(uint16_t keys);
+  /* The keys down now or pressed at any point since the last call. A key
+   * tapped between two frames is thereby seen for one frame, rather than
+   * not at all, when the keypad is sampled once per frame.
+   */
+  uint16_t TakeFrameKeys();
+
+  /* The keypad key mapped to a host key, or NUM_KEYS if there is none */
+  int KeyOf(SDL_Keycode keycode) const;
+
  private:
-  std::array<bool, KEYBOARD_SIZE> m_keyboard{false};
-  std::array<SDL_Keycode, KEYBOARD_SIZE> m_keycode_map{
+  uint16_t m_down{0};
+  /* Keys pressed since WaitForKey(), one bit each */
+  uint16_t m_wait_pressed{0};
+  /* The first of those to be released, or NUM_KEYS while none has been */
+  uint8_t m_released{NUM_KEYS};
+  /* Keys pressed since the last TakeFrameKeys() */
+  uint16_t m_frame_pressed{0};
+  /* In the order the events arrived, so by slice */
+  std::array<KeyChange, INPUT_QUEUE_SIZE> m_queue{};
+  size_t m_queued{0};
+  std::array<SDL_Keycode, NUM_KEYS> m_keycode_map{
       SDLK_x,                         // 0 -> x
       SDLK_1, SDLK_2, SDLK_3,         // 1 2 3
       SDLK_q, SDLK_w, SDLK_e,         // 4 5 6
@@ -28,6 +87,10 @@ class Input {
       SDLK_z, SDLK_c,                 // A   B
       SDLK_4, SDLK_r, SDLK_f, SDLK_v  // C D E F (right vertical side)
   };
+
+  void Apply(const KeyChange &change);
+  void Press(int key);
+  void Release(int key);
 };
 
 }  // namespace cchip8
@@ -1,6 +1,7 @@
 #ifndef CCHIP8_INSTRUCTION_H_
 #define CCHIP8_INSTRUCTION_H_
 
+#include <cstddef>
 #include <cstdint>
 
 namespace cchip8 {
@@ -8,12 +9,21 @@ namespace cchip8 {
 enum class Opcode {
   CLS,
   RET,
+  SCD,
+  SCU,
+  SCR,
+  SCL,
+  EXIT,
+  LOW,
+  HIGH,
   SYS,
   JP,
   CALL,
   SE_VX_KK,
   SNE_VX_KK,
   SE_VX_VY,
+  LD_I_VX_VY,
+  LD_VX_VY_I,
   LD_VX_KK,
   ADD_VX_KK,
   LD_VX_VY,
@@ -32,38 +42,54 @@ enum class Opcode {
   DRW_VX_VY,
   SKP_VX,
   SKNP_VX,
+  LD_I_LONG,
+  PLANE,
   LD_VX_DT,
   LD_VX_K,
   LD_DT_VX,
   LD_ST_VX,
   ADD_I_VX,
   LD_F_VX,
+  LD_HF_VX,
   LD_B_VX,
   LD_I_VX,
   LD_VX_I,
+  LD_R_VX,
+  LD_VX_R,
   UNKNOWN,
 };
 
+#define NUM_OPCODES (static_cast<size_t>(Opcode::UNKNOWN) + 1)
+
 class Instruction {
  public:
-  Instruction(const uint16_t instruction) : m_instruction(instruction) {}
+  /* Operands are extracted once here so that cached instructions can be
+   * executed without masking the raw word again.
+   */
+  constexpr Instruction(const uint16_t instruction)
+      : m_instruction(instruction),
+        m_addr(instruction & 0x0FFF),
+        m_x((instruction & 0x0F00) >> 8),
+        m_y((instruction & 0x00F0) >> 4),
+        m_kk(instruction & 0x00FF),
+        m_n(instruction & 0x000F) {}
 
   /* A 12-bit value, the lowest 12 bits of the instruction */
-  uint16_t addr() const { return m_instruction & 0x0FFF; }
+  constexpr uint16_t addr() const { return m_addr; }
   /* A 4-bit value, the lowest 4 bits of the instruction */
-  uint8_t n() const { return m_instruction & 0x000F; }
+  constexpr uint8_t n() const { return m_n; }
   /* The most significant nibble */
-  uint8_t msn() const { return m_instruction >> 12; }
+  constexpr uint8_t msn() const { return m_instruction >> 12; }
   /* A 4-bit value, the lower 4 bits of the high byte of the instruction */
-  uint8_t x() const { return (m_instruction & 0x0F00) >> 8; }
+  constexpr uint8_t x() const { return m_x; }
   /* A 4-bit value, the upper 4 bits of the low byte of the instruction */
-  uint8_t y() const { return (m_instruction & 0x00F0) >> 4; }
+  constexpr uint8_t y() const { return m_y; }
   /* An 8-bit value, the lowest 8 bits of the instruction */
-  uint8_t kk() const { return m_instruction & 0x00FF; }
+  constexpr uint8_t kk() const { return m_kk; }
   /* The full instruction as bytes */
-  uint16_t instruction() const { return m_instruction; }
+  constexpr uint16_t instruction() const { return m_instruction; }
 
-  Opcode Decode() const {
+  constexpr Opcode Decode() const {
     switch (msn()) {
       case 0x00:
         switch (addr()) {
@@ -71,7 +97,19 @@ class Instruction {
             return Opcode::CLS;
           case 0x0EE:
             return Opcode::RET;
+          case 0x0FB:
+            return Opcode::SCR;
+          case 0x0FC:
+            return Opcode::SCL;
+          case 0x0FD:
+            return Opcode::EXIT;
+          case 0x0FE:
+            return Opcode::LOW;
+          case 0x0FF:
+            return Opcode::HIGH;
           default:
+            if ((addr() & 0xFF0) == 0x0C0) return Opcode::SCD;
+            if ((addr() & 0xFF0) == 0x0D0) return Opcode::SCU;
             return Opcode::SYS;
         }
       case 0x01:
@@ -83,7 +121,14 @@ class Instruction {
       case 0x04:
         return Opcode::SNE_VX_KK;
       case 0x05:
-        return Opcode::SE_VX_VY;
+        switch (n()) {
+          case 0x02:
+            return Opcode::LD_I_VX_VY;
+          case 0x03:
+            return Opcode::LD_VX_VY_I;
+          default:
+            return Opcode::SE_VX_VY;
+        }
       case 0x06:
         return Opcode::LD_VX_KK;
       case 0x07:
@@ -132,6 +177,10 @@ class Instruction {
         }
       case 0x0F:
         switch (kk()) {
+          case 0x00:
+            return x() == 0 ? Opcode::LD_I_LONG : Opcode::UNKNOWN;
+          case 0x01:
+            return Opcode::PLANE;
           case 0x07:
             return Opcode::LD_VX_DT;
           case 0x0A:
@@ -144,12 +193,18 @@ class Instruction {
             return Opcode::ADD_I_VX;
           case 0x29:
             return Opcode::LD_F_VX;
+          case 0x30:
+            return Opcode::LD_HF_VX;
           case 0x33:
             return Opcode::LD_B_VX;
           case 0x55:
             return Opcode::LD_I_VX;
           case 0x65:
             return Opcode::LD_VX_I;
+          case 0x75:
+            return Opcode::LD_R_VX;
+          case 0x85:
+            return Opcode::LD_VX_R;
           default:
             return Opcode::UNKNOWN;
         }
@@ -159,7 +214,19 @@ class Instruction {
   }
 
  private:
-  const uint16_t m_instruction;
+  uint16_t m_instruction;
+  uint16_t m_addr;
+  uint8_t m_x;
+  uint8_t m_y;
+  uint8_t m_kk;
+  uint8_t m_n;
+};
+
+/* An instruction predecoded from RAM, cached per address by Memory */
+struct DecodedInstruction {
+  Instruction instruction{0};
+  Opcode opcode{Opcode::UNKNOWN};
+  bool valid{false};
 };
 
 }  // namespace cchip8
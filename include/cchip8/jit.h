@@ -0,0 +1,78 @@
+#ifndef CCHIP8_JIT_H_
+#define CCHIP8_JIT_H_
+
+#include <cchip8/cpu.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#define JIT_CODE_SIZE (256 * 1024)
+#define JIT_MAX_BLOCK_LENGTH 32
+
+namespace cchip8 {
+
+class Machine;
+
+/*
+ * Translates straight-line runs of CHIP-8 instructions starting at the
+ * program counter into x86-64 code operating directly on the Cpu.
+ *
+ * Only instructions that touch nothing but the registers, I and pc are
+ * translated. A block ends at the first one that draws, reads the keypad or
+ * timers, touches memory or the stack, or may change pc; that instruction is
+ * then run by the interpreter. Blocks are dropped whenever the memory's code
+ * generation changes, which happens when LD [I], Vx or LD B, Vx overwrite
+ * bytes that have been decoded as code.
+ */
+class Jit {
+ public:
+  Jit();
+  ~Jit();
+  Jit(const Jit&) = delete;
+  Jit& operator=(const Jit&) = delete;
+
+  /* Whether this build and host can run translated code at all */
+  static bool Supported();
+
+  /* Runs the machine for the given number of instructions. In compare mode
+   * each block is also run by the interpreter and any difference in the
+   * resulting Cpu state is reported. Returns the ticks left over when the
+   * CPU stopped early.
+   */
+  int Run(Machine& machine, int ticks, bool compare);
+  void Flush();
+  /* Translates for the profile from now on, dropping every block */
+  void SetQuirks(const Quirks quirks);
+
+  uint64_t Mismatches() const { return m_mismatches; }
+
+ private:
+  /* Returns the number of instructions executed, at most budget */
+  using BlockFn = int (*)(Cpu* cpu, int budget);
+
+  enum class BlockState : uint8_t { Untranslated, Translated, Interpret };
+
+  struct Block {
+    BlockFn fn{nullptr};
+    BlockState state{BlockState::Untranslated};
+  };
+
+  const Block& Lookup(Memory& memory, const uint16_t pc);
+  template <typename Quirks>
+  Block Translate(Memory& memory, const uint16_t pc);
+  int RunCompare(Machine& machine, const Block& block, int budget);
+
+  std::array<Block, RAM_SIZE> m_blocks{};
+  uint8_t* m_code{nullptr};
+  size_t m_code_used{0};
+  uint32_t m_generation{0};
+  uint64_t m_mismatches{0};
+  Block (Jit::*m_translate)(Memory& memory, const uint16_t pc);
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_JIT_H_
@@ -0,0 +1,44 @@
+#ifndef CCHIP8_LATENCY_H_
+#define CCHIP8_LATENCY_H_
+
+#include <cchip8/timing_history.h>
+
+#include <cstdint>
+
+/* Presses kept for the percentiles */
+#define LATENCY_HISTORY 1024
+
+namespace cchip8 {
+
+/*
+ * Measures key to photon latency: from the timestamp of a keypad press to
+ * the present of the first frame the machine drew after running with it.
+ * That covers the event queue, the wait for the next frame, emulation,
+ * the handover to the renderer and the present, but not the display's own
+ * scan-out. A press whose frames change nothing on screen is not measured,
+ * rather than matched with whatever changes next, and neither is one whose
+ * frame was replaced before it could be presented.
+ */
+class LatencyProbe {
+ public:
+  LatencyProbe() : m_history(LATENCY_HISTORY) {}
+
+  /* Both times in nanoseconds on the same clock */
+  void Record(uint64_t pressed, uint64_t presented);
+
+  uint64_t Count() const { return m_count; }
+  /* The p-th percentile, 0 to 100, of the latest latencies in milliseconds,
+   * or 0 before any were measured
+   */
+  double Percentile(double p) const { return m_history.Percentile(p); }
+  double Max() const { return static_cast<double>(m_max) / 1e6; }
+
+ private:
+  TimingHistory m_history;
+  uint64_t m_count{0};
+  uint64_t m_max{0};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_LATENCY_H_
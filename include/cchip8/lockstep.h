@@ -0,0 +1,172 @@
+#ifndef CCHIP8_LOCKSTEP_H_
+#define CCHIP8_LOCKSTEP_H_
+
+#include <cchip8/cpu.h>
+#include <cchip8/instruction.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Lane arrays are padded to a multiple of this many bytes, one AVX-512
+ * register
+ */
+#define LOCKSTEP_LANE_ALIGN 64
+/* Groups holding fewer than 1/LOCKSTEP_SPARSE_RATIO of the lanes are run
+ * over their lane indices instead of masked over every lane
+ */
+#define LOCKSTEP_SPARSE_RATIO 8
+/* Set in a lane's wait word while it is halted in Fx0A, above the mask of
+ * keys pressed since
+ */
+#define LOCKSTEP_WAITING 0x10000
+
+namespace cchip8 {
+
+/*
+ * Runs many instances of the same ROM side by side, differing only in their
+ * keypad input and RNG seed. Registers, I, pc, sp and the timers are kept
+ * as structure-of-arrays with one element per lane, so an instruction is
+ * executed for every lane at once by loops the compiler turns into vector
+ * code.
+ *
+ * Lanes are grouped by pc. While they agree there is a single group and
+ * every instruction is decoded once and run across all lanes. When a branch
+ * makes them diverge, each group runs with the other lanes masked off, and
+ * a group is split by pc at the next block boundary, i.e. after any
+ * instruction that may change pc. Small groups are run over a list of their
+ * lanes, so that many diverged groups do not each cost a pass over every
+ * lane. Instructions that touch memory, the stack
+ * or the display run lane by lane through the scalar Cpu from cpu.cpp,
+ * which stays the reference for every instruction's semantics.
+ */
+class Lockstep {
+ public:
+  Lockstep(const Rom& rom, size_t lanes, Quirks quirks = Quirks::Modern);
+
+  size_t Lanes() const { return m_lanes; }
+  size_t Groups() const { return m_groups.size(); }
+
+  void SetKeypad(size_t lane, uint16_t keys) { m_keys.at(lane) = keys; }
+  void Seed(size_t lane, uint64_t seed);
+
+  void RunFrame(const int ticks);
+  void Run(int ticks);
+  void Step();
+  void UpdateTimers();
+
+  /* Whether a lane has raised a guest fault, or stopped for good on one or
+   * on 00FD. Stopped lanes are taken out of their group and never run again.
+   */
+  bool Faulted(size_t lane) const {
+    return MemoryPolicy::checked && m_faults.at(lane).kind != FaultKind::None;
+  }
+  bool Stopped(size_t lane) const { return m_stopped.at(lane) != 0; }
+  /* The instructions a lane has run, leaving out the steps it spent halted
+   * in Fx0A or stopped, as Machine::Stats::Executed() does
+   */
+  uint64_t Executed(size_t lane) const;
+
+  /* A copy of a lane's CPU state, in the scalar layout */
+  Cpu LaneCpu(size_t lane) const;
+  const Memory& LaneMemory(size_t lane) const { return m_memory.at(lane); }
+
+ private:
+  struct Group {
+    uint16_t pc;
+    /* 0xFF for each lane in the group, 0 otherwise */
+    std::vector<uint8_t> mask;
+    std::vector<uint32_t> lanes;
+    /* Ran an instruction that may change pc, so its lanes may have split */
+    bool branched{false};
+  };
+
+  /* Calls body(lane, mask) for the lanes of a group. The dense form visits
+   * every lane with its mask and is the one that vectorizes.
+   */
+  template <typename Body>
+  void ForEach(const Group& group, Body body) {
+    const size_t stride = m_stride;
+    if (group.lanes.size() * LOCKSTEP_SPARSE_RATIO < stride) {
+      for (const auto lane : group.lanes) body(lane, uint8_t{0xFF});
+    } else {
+      const uint8_t* mask = group.mask.data();
+      for (size_t lane = 0; lane < stride; ++lane) body(lane, mask[lane]);
+    }
+  }
+
+  uint8_t* V(uint8_t reg) { return m_registers.data() + (reg * m_stride); }
+  uint16_t Word(size_t lane, uint16_t pc) const;
+  uint8_t SkipLength(const Group& group) const;
+
+  template <typename Quirks>
+  void Execute(Group& group);
+  template <typename Quirks>
+  bool ExecuteVector(const Group& group, const Instruction& instruction,
+                     Opcode opcode);
+  template <typename Quirks>
+  void ExecuteLane(size_t lane, const Instruction& instruction, Opcode opcode);
+  void Wake();
+  void StoreLaneCpu(size_t lane, const Cpu& cpu);
+  void RemoveStopped(Group& group);
+  void Regroup();
+
+  size_t m_lanes;
+  size_t m_stride;
+  /* Execute() instantiated for the quirks profile */
+  void (Lockstep::*m_execute)(Group& group);
+
+  std::vector<uint8_t> m_registers{};
+  std::vector<uint16_t> m_I{};
+  std::vector<uint16_t> m_pc{};
+  std::vector<uint8_t> m_sp{};
+  std::vector<uint8_t> m_delay{};
+  std::vector<uint8_t> m_sound{};
+  std::vector<uint16_t> m_keys{};
+  /* LOCKSTEP_WAITING and the keys pressed since, for lanes halted in Fx0A.
+   * A halted lane stays on the instruction until Run() finds one of those
+   * keys released.
+   */
+  std::vector<uint32_t> m_wait{};
+  /* Set for lanes stopped by 00FD, which stay on the instruction */
+  std::vector<uint8_t> m_exited{};
+  /* The first fault each lane raised, which leaves it on the instruction */
+  std::vector<GuestFault> m_faults{};
+  /* 0xFF for lanes that exited or faulted, 0 otherwise */
+  std::vector<uint8_t> m_stopped{};
+  /* Some lane has stopped since its group last dropped its stopped lanes */
+  bool m_stopping{false};
+  /* Steps run so far, and for each lane the step it stopped on and the
+   * steps it spent halted, so that Executed() needs no count per lane and
+   * step
+   */
+  uint64_t m_steps{0};
+  std::vector<uint64_t> m_stopped_at{};
+  std::vector<uint64_t> m_halted_steps{};
+  /* Each word of the RNG state, as RandomState, for every lane */
+  std::vector<uint32_t> m_rng{};
+  std::vector<Memory> m_memory{};
+
+  std::vector<Group> m_groups{};
+  /* Emptied groups, kept to reuse their masks */
+  std::vector<Group> m_spare{};
+  /* Index into m_groups by pc while regrouping, -1 when there is none */
+  std::vector<int32_t> m_group_at{};
+  /* Lanes waiting to be placed in a group by pc */
+  std::vector<uint32_t> m_loose{};
+  bool m_regroup{false};
+
+  /* Addresses that have been executed, and whether any lane has written to
+   * one of them since. Until then every lane is known to hold the same code.
+   */
+  std::bitset<RAM_SIZE> m_code{};
+  bool m_self_modified{false};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_LOCKSTEP_H_
@@ -0,0 +1,149 @@
+#ifndef CCHIP8_MACHINE_H_
+#define CCHIP8_MACHINE_H_
+
+#include <cchip8/cpu.h>
+#include <cchip8/input.h>
+#include <cchip8/instruction.h>
+#include <cchip8/jit.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <cchip8/superblock.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#define TICKS_PER_FRAME 10
+/* The instructions per frame can be set between these, 60 to about 3.9M IPS */
+#define MIN_TICKS_PER_FRAME 1
+#define MAX_TICKS_PER_FRAME 65536
+/* Longest loop, in instructions, that is recognised as idle */
+#define IDLE_MAX_LOOP_LENGTH 4
+/* How many ticks run between checks for an idle loop */
+#define IDLE_PROBE_INTERVAL 64
+/* A frame is run in this many slices and the sound timer is noted for each,
+ * which places the tone's edges to within 1/480 s. Queued key changes are
+ * applied between slices. Half of them run before the timer update and
+ * half after.
+ */
+#define SOUND_SLICES 8
+
+namespace cchip8 {
+
+enum class Backend {
+  Interpreter,
+  Superblock,
+  Jit,
+  /* Runs every translated block through the interpreter as well and reports
+   * any difference
+   */
+  JitCompare,
+};
+
+struct MachineStats {
+  /* Every tick asked of Run(), including skipped ones */
+  uint64_t ticks{0};
+  /* Ticks not interpreted because the program was in an idle loop */
+  uint64_t skipped{0};
+  /* Ticks that passed with the CPU halted in Fx0A */
+  uint64_t halted{0};
+  /* Ticks that passed after 00FD or a guest fault stopped the CPU */
+  uint64_t stopped{0};
+
+  /* The instructions actually interpreted */
+  uint64_t Executed() const { return ticks - skipped - halted - stopped; }
+};
+
+/*
+ * The emulated machine without any host devices attached: the CPU, its memory
+ * and the keypad. Everything needed to run a program lives here, so a Machine
+ * can be stepped headless and independently of any other instance.
+ */
+class Machine {
+ public:
+  /* The size of the state written by SaveState(). It lists the same fields
+   * as VisitState() in machine.cpp, in bytes and without padding.
+   */
+  static constexpr size_t STATE_SIZE =
+      sizeof(Cpu::registers) + sizeof(Cpu::I) + sizeof(Cpu::pc) +
+      sizeof(Cpu::sp) + sizeof(Cpu::t_delay) + sizeof(Cpu::t_sound) +
+      sizeof(Cpu::seed) + sizeof(Cpu::rng) + sizeof(GuestFault::kind) +
+      sizeof(GuestFault::pc) + sizeof(GuestFault::opcode) +
+      sizeof(GuestFault::address) + sizeof(Cpu::halted) +
+      sizeof(Cpu::exited) + sizeof(Memory::ram) + sizeof(Framebuffer::planes) +
+      sizeof(Framebuffer::selected) + sizeof(Framebuffer::hires) +
+      sizeof(Memory::stack) + sizeof(Memory::rpl);
+
+  Machine();
+
+  Cpu cpu{};
+  Memory memory{};
+  Input input{};
+
+  /* Set when an instruction changed the display since the last redraw */
+  bool draw{false};
+  /* Bit i is set when the sound timer was running at the start of slice i
+   * of the last frame
+   */
+  uint8_t sound{0};
+
+  MachineStats stats{};
+
+  bool Load(const Rom& rom);
+  [[nodiscard]] bool SetBackend(const Backend backend);
+  Backend GetBackend() const { return m_backend; }
+
+  /* Picks the interpreter, handler table and superblock and JIT code built
+   * for the profile
+   */
+  void SetQuirks(const Quirks quirks);
+  Quirks GetQuirks() const { return m_quirks; }
+
+  /* Whether Run() fast-forwards through idle loops. The result is exactly
+   * what interpreting them would give.
+   */
+  void SetIdleSkip(const bool enabled) { m_idle_skip = enabled; }
+
+  /* Runs one 60 Hz frame: half the instructions, a timer update, then the
+   * other half, each half in SOUND_SLICES / 2 slices. The keypad changes
+   * queued for a slice are applied before it runs.
+   */
+  void RunFrame(const int ticks);
+  void Run(int ticks);
+  void Tick();
+  void UpdateTimers();
+
+  /* Copies everything a program can change, the Cpu and Memory but not the
+   * keypad or any cache, to or from STATE_SIZE bytes. Loading a state drops
+   * the decoded and translated code and redraws the display.
+   */
+  void SaveState(uint8_t* out) const;
+  void LoadState(const uint8_t* in);
+
+ private:
+  const DecodedInstruction& Fetch();
+  template <typename Quirks>
+  void Execute(const DecodedInstruction& decoded);
+  template <typename Quirks>
+  void TickAs();
+  template <typename Quirks>
+  int Interpret(int ticks);
+  int RunBackend(int ticks);
+  void Wake();
+  int SkipIdle(const int ticks);
+  int FindIdleLoop(const uint16_t pc, uint16_t& head);
+  int RunToHead(const uint16_t head, const int length);
+
+  Backend m_backend{Backend::Interpreter};
+  Quirks m_quirks{Quirks::Modern};
+  void (Machine::*m_tick)(){nullptr};
+  int (Machine::*m_interpret)(int){nullptr};
+  bool m_idle_skip{true};
+  std::unique_ptr<Superblocks> m_superblocks{};
+  std::unique_ptr<Jit> m_jit{};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_MACHINE_H_
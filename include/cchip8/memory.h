@@ -2,18 +2,36 @@
 #define CCHIP8_MEMORY_H_
 
 #include <cchip8/display.h>
+#include <cchip8/framebuffer.h>
+#include <cchip8/instruction.h>
 #include <cchip8/rom.h>
 
 #include <array>
 #include <cstdint>
+#include <memory>
 
-#define RAM_SIZE 4096
+/* XO-CHIP's 64 KB. CHIP-8 and SUPER-CHIP programs only use the first 4 KB,
+ * as nnn operands are 12 bits.
+ */
+#define RAM_SIZE 65536
+#define RAM_MASK (RAM_SIZE - 1)
 #define STACK_SIZE 16
+#define STACK_MASK (STACK_SIZE - 1)
 
 #define SPRITES_SIZE 80
 #define SPRITE_SIZE 5
 #define SPRITES_LOCATION 0x50
 
+/* The SUPER-CHIP 8x10 digits, for Fx30 */
+#define BIG_SPRITES_SIZE 160
+#define BIG_SPRITE_SIZE 10
+#define BIG_SPRITES_LOCATION (SPRITES_LOCATION + SPRITES_SIZE)
+
+/* The HP-48 flag registers saved and restored by Fx75 and Fx85. SUPER-CHIP
+ * has 8, later extensions 16.
+ */
+#define RPL_SIZE 16
+
 #define PROGRAM_START 0x200
 
 static constexpr std::array<uint8_t, SPRITES_SIZE> SPRITES = {
@@ -35,12 +53,93 @@ static constexpr std::array<uint8_t, SPRITES_SIZE> SPRITES = {
     0xF0, 0x80, 0xF0, 0x80, 0x80   // F
 };
 
+static constexpr std::array<uint8_t, BIG_SPRITES_SIZE> BIG_SPRITES = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF,  // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF,  // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,  // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03,  // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,  // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18,  // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,  // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3,  // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC,  // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C,  // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,  // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,  // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0   // F
+};
+
 namespace cchip8 {
 
+/*
+ * How guest addresses and stack indices become indices into Memory. Every
+ * access in Cpu goes through the policy, which is fixed at compile time:
+ *
+ * FastMemory wraps addresses to the address space and stack indices to 4
+ * bits, so every access is in bounds by construction and no check is left.
+ *
+ * CheckedMemory leaves them as they are and reports whether they are in
+ * range, so the caller can raise a guest fault instead of touching memory.
+ * Build with CCHIP8_CHECKED_MEMORY to select it.
+ *
+ * The address space is all of RAM unless the caller passes a smaller Size,
+ * a power of two, as the instructions do for profiles limited to 4 KiB.
+ */
+struct FastMemory {
+  static constexpr bool checked = false;
+
+  template <uint32_t Size = RAM_SIZE>
+  static constexpr bool InRam(uint32_t, uint32_t) {
+    return true;
+  }
+  template <uint32_t Size = RAM_SIZE>
+  static constexpr uint16_t Ram(uint32_t address) {
+    return address & (Size - 1);
+  }
+  static constexpr bool InStack(uint32_t) { return true; }
+  static constexpr bool CanReturn(uint32_t) { return true; }
+  static constexpr uint8_t Stack(uint32_t index) { return index & STACK_MASK; }
+};
+
+struct CheckedMemory {
+  static constexpr bool checked = true;
+
+  /* Whether the `length` bytes starting at `address` all lie in RAM */
+  template <uint32_t Size = RAM_SIZE>
+  static constexpr bool InRam(uint32_t address, uint32_t length) {
+    return address + length <= Size;
+  }
+  template <uint32_t Size = RAM_SIZE>
+  static constexpr uint16_t Ram(uint32_t address) {
+    return address;
+  }
+  static constexpr bool InStack(uint32_t index) { return index < STACK_SIZE; }
+  /* Whether a RET with this stack pointer pops a return address. CALL
+   * increments sp before storing, so slot 0 never holds one.
+   */
+  static constexpr bool CanReturn(uint32_t index) {
+    return index > 0 && index < STACK_SIZE;
+  }
+  static constexpr uint8_t Stack(uint32_t index) { return index; }
+};
+
+#ifdef CCHIP8_CHECKED_MEMORY
+using MemoryPolicy = CheckedMemory;
+#else
+using MemoryPolicy = FastMemory;
+#endif
+
 /*
  * Memory Map
  * http://devernay.free.fr/hacks/chip8/C8TECH10.HTM#3.0
  *
+ * +---------------+= 0xFFFF (65535) End of XO-CHIP RAM
+ * |               |
+ * | XO-CHIP only  |
+ * |               |
  * +---------------+= 0xFFF (4095) End of Chip-8 RAM
  * |               |
  * |               |
@@ -69,19 +168,51 @@ namespace cchip8 {
 class Memory {
  public:
   std::array<uint8_t, RAM_SIZE> ram{};
-  std::array<bool, DISPLAY_SIZE> vram{};
+  Framebuffer vram{};
   std::array<uint16_t, STACK_SIZE> stack{};
+  std::array<uint8_t, RPL_SIZE> rpl{};
 
   void Reset();
   bool LoadProgram(const Rom& rom, const size_t location);
 
-  void ClearVram() { vram.fill(false); }
-  void ClearRam() { ram.fill(0); }
+  /* Programs that write to RAM must go through Write() so that any cached
+   * instruction overlapping the written byte is decoded again. Addresses
+   * passed to Write() and Decode() wrap to 16 bits.
+   */
+  void Write(const uint16_t address, const uint8_t value);
+  const DecodedInstruction& Decode(const uint16_t address);
+
+  /* Bumped whenever a byte that has been decoded as code is overwritten or
+   * the cache is cleared, so translated code can tell that it is stale.
+   */
+  uint32_t CodeGeneration() const { return m_code_generation; }
+
+  /* FNV-1a over the display, for comparing frames between runs and telling
+   * whether a frame changed. Cached until the display next changes.
+   */
+  uint64_t FrameHash() const { return vram.Hash(); }
+
+  void ClearVram() { vram.Clear(); }
+  void ClearRam() {
+    ram.fill(0);
+    ClearDecodeCache();
+  }
+  void ClearDecodeCache() {
+    if (m_decoded != nullptr) m_decoded->fill(DecodedInstruction{});
+    ++m_code_generation;
+  }
 
   void DumpMem() const;
   void DumpStack() const;
   void PrintByte(const uint8_t& byte) const;
   void PrintAddress(const uint16_t& address) const;
+
+ private:
+  /* Allocated on the first Decode(), so that memories which are never
+   * executed from directly stay small
+   */
+  std::unique_ptr<std::array<DecodedInstruction, RAM_SIZE>> m_decoded{};
+  uint32_t m_code_generation{0};
 };
 
 }  // namespace cchip8
@@ -8,7 +8,12 @@
 #include <vector>
 
 #define MENU_FONT_SIZE 36
-#define MENU_WIDTH (DISPLAY_WIDTH / 4) * DISPLAY_SCALE
+/* The menu is laid out in an area of this size, which is kept centred in
+ * the window whatever its size
+ */
+#define MENU_AREA_WIDTH 640
+#define MENU_AREA_HEIGHT 320
+#define MENU_WIDTH (MENU_AREA_WIDTH / 4)
 #define MENU_X (MENU_WIDTH + (MENU_WIDTH / 2))
 #define MENU_ITEM_BORDER 5
 
@@ -26,6 +31,8 @@ namespace cchip8 {
 class Menu {
  public:
   void Init(const float pos_x, const float pos_y, SDL_Renderer *renderer);
+  /* Centres the menu area in an output of `width` by `height` pixels */
+  void Place(const int width, const int height);
   void Display();
   void SelectUp();
   void SelectDown();
@@ -41,6 +48,9 @@ class Menu {
   float m_pos_y{0.0};
 
   float m_menu_height{0.0};
+  /* Where the menu area's top left corner is drawn */
+  float m_origin_x{0.0};
+  float m_origin_y{0.0};
 
   SDL_Renderer *m_renderer = nullptr;
   MenuItem m_header{};
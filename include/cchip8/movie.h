@@ -0,0 +1,71 @@
+#ifndef CCHIP8_MOVIE_H_
+#define CCHIP8_MOVIE_H_
+
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define MOVIE_VERSION 1
+/* "C8MV" */
+#define MOVIE_MAGIC 0x564D3843
+/* A day at 60 frames per second. Longer runs in a file are taken as damage
+ * rather than allocated.
+ */
+#define MOVIE_MAX_FRAMES (60 * 60 * 60 * 24)
+
+namespace cchip8 {
+
+struct PlaybackResult {
+  uint64_t frames{0};
+  /* FNV-1a chained over every frame's display hash, then the final state */
+  uint64_t hash{0};
+  double seconds{0.0};
+};
+
+/*
+ * A recording of the keypad, sampled once per frame, together with
+ * everything else a run depends on: the seed, the quirks profile, the
+ * instructions per frame and the ROM. Time is counted in emulated frames
+ * only, so replaying the keys into a machine set up the same way gives
+ * the same frames, on any host and at any speed.
+ *
+ * On disk, a header is followed by runs of identical frames, each the
+ * 16-bit key mask and a LEB128 count. Keys change rarely, so an hour of
+ * play takes a few kilobytes.
+ */
+class Movie {
+ public:
+  uint64_t seed{0};
+  uint64_t rom_hash{0};
+  Quirks quirks{Quirks::Modern};
+  int ticks_per_frame{TICKS_PER_FRAME};
+
+  void Clear() { m_keys.clear(); }
+  void Record(const uint16_t keys) { m_keys.push_back(keys); }
+  size_t Frames() const { return m_keys.size(); }
+  uint16_t Keys(const size_t frame) const { return m_keys[frame]; }
+
+  [[nodiscard]] bool Save(const std::string& filename) const;
+  /* Leaves the movie as it was if the file is damaged */
+  [[nodiscard]] bool Load(const std::string& filename);
+
+  /* Sets up a machine for the movie: loads the ROM, picks the profile and
+   * seeds RND. Fails if the ROM is not the one recorded.
+   */
+  [[nodiscard]] bool Prepare(const Rom& rom, Machine& machine) const;
+  /* Plays the whole movie on a fresh machine as fast as the host allows */
+  [[nodiscard]] bool Play(const Rom& rom, Backend backend,
+                          PlaybackResult& result) const;
+
+ private:
+  std::vector<uint16_t> m_keys{};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_MOVIE_H_
@@ -0,0 +1,82 @@
+#ifndef CCHIP8_QUIRKS_H_
+#define CCHIP8_QUIRKS_H_
+
+#include <cstdint>
+#include <string>
+
+namespace cchip8 {
+
+/*
+ * The behaviours on which CHIP-8 interpreters disagree. Each profile below
+ * is a struct of constants that the CPU core takes as a template parameter,
+ * so every profile compiles into its own interpreter and no quirk is checked
+ * while instructions run. The profile for a run is picked once, by choosing
+ * which instantiation to call.
+ */
+enum class Quirks {
+  /* The original COSMAC VIP interpreter */
+  Chip8,
+  /* SUPER-CHIP 1.1 on the HP 48 */
+  SuperChip,
+  /* What cchip8 has always done, and the default */
+  Modern,
+};
+
+struct Chip8Quirks {
+  /* 8xy1, 8xy2 and 8xy3 set VF to 0 */
+  static constexpr bool vf_reset = true;
+  /* 8xy6 and 8xyE shift Vy into Vx instead of shifting Vx in place */
+  static constexpr bool shift_vy = true;
+  /* Fx55 and Fx65 leave I just past the last register */
+  static constexpr bool increment_i = true;
+  /* Bxnn jumps to xnn + Vx instead of nnn + V0 */
+  static constexpr bool jump_vx = false;
+  /* Sprites are cut off at the edges of the display instead of wrapping */
+  static constexpr bool clip = true;
+  /* Bytes of RAM that I addresses, past which accesses wrap, or fault with
+   * checked memory. Only XO-CHIP, run as Modern, has 64 KiB.
+   */
+  static constexpr uint32_t ram_size = 0x1000;
+};
+
+struct SuperChipQuirks {
+  static constexpr bool vf_reset = false;
+  static constexpr bool shift_vy = false;
+  static constexpr bool increment_i = false;
+  static constexpr bool jump_vx = true;
+  static constexpr bool clip = true;
+  static constexpr uint32_t ram_size = 0x1000;
+};
+
+struct ModernQuirks {
+  static constexpr bool vf_reset = false;
+  static constexpr bool shift_vy = false;
+  static constexpr bool increment_i = false;
+  static constexpr bool jump_vx = false;
+  static constexpr bool clip = false;
+  static constexpr uint32_t ram_size = 0x10000;
+};
+
+/* Calls fn with a value of the profile's type, e.g. to take the address of
+ * a function template instantiated for it
+ */
+template <typename Fn>
+auto WithQuirks(const Quirks quirks, Fn fn) {
+  switch (quirks) {
+    case Quirks::Chip8:
+      return fn(Chip8Quirks{});
+    case Quirks::SuperChip:
+      return fn(SuperChipQuirks{});
+    case Quirks::Modern:
+    default:
+      return fn(ModernQuirks{});
+  }
+}
+
+const char* QuirksName(const Quirks quirks);
+/* Accepts the names QuirksName() returns */
+bool ParseQuirks(const std::string& name, Quirks& quirks);
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_QUIRKS_H_
@@ -0,0 +1,52 @@
+#ifndef CCHIP8_RANDOM_H_
+#define CCHIP8_RANDOM_H_
+
+#include <array>
+#include <cstdint>
+
+#define DEFAULT_SEED 0x5EED5EED5EED5EEDULL
+
+namespace cchip8 {
+
+/*
+ * The state of xoshiro128** (Blackman and Vigna), the generator behind RND.
+ * It is 16 bytes, takes a handful of ALU operations per number and has a
+ * period of 2^128 - 1, so it can live in every Cpu and be copied with it.
+ */
+using RandomState = std::array<uint32_t, 4>;
+
+constexpr uint32_t RotateLeft(const uint32_t x, const int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+/* Expands a 64-bit seed into a full state with SplitMix64, as recommended
+ * by the xoshiro authors
+ */
+constexpr RandomState SeedRandom(uint64_t seed) {
+  RandomState state{};
+  for (auto i = 0; i < 2; ++i) {
+    uint64_t z = (seed += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    z ^= z >> 31;
+    state[2 * i] = static_cast<uint32_t>(z);
+    state[(2 * i) + 1] = static_cast<uint32_t>(z >> 32);
+  }
+  return state;
+}
+
+constexpr uint32_t NextRandom(RandomState& state) {
+  const uint32_t result = RotateLeft(state[1] * 5, 7) * 9;
+  const uint32_t t = state[1] << 9;
+  state[2] ^= state[0];
+  state[3] ^= state[1];
+  state[1] ^= state[2];
+  state[0] ^= state[3];
+  state[2] ^= t;
+  state[3] = RotateLeft(state[3], 11);
+  return result;
+}
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_RANDOM_H_
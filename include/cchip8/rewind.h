@@ -0,0 +1,86 @@
+#ifndef CCHIP8_REWIND_H_
+#define CCHIP8_REWIND_H_
+
+#include <cchip8/machine.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/* Holds over ten minutes of frames for the usual program, whose frames
+ * change little beyond the registers and a few display rows
+ */
+#define REWIND_BUFFER_SIZE (8 * 1024 * 1024)
+/* Every Nth frame is stored whole rather than as a delta */
+#define REWIND_KEYFRAME_INTERVAL 300
+
+namespace cchip8 {
+
+struct RewindStats {
+  uint64_t captures{0};
+  std::chrono::nanoseconds capture_time{0};
+  std::chrono::nanoseconds capture_max{0};
+};
+
+/*
+ * A history of machine states, one per frame, in a ring of fixed size.
+ *
+ * Each frame is stored as the XOR of its state with the previous frame's,
+ * run-length encoded, so the bytes a frame did not touch cost almost nothing.
+ * Every REWIND_KEYFRAME_INTERVAL frames the state is stored whole instead,
+ * encoded the same way against zero. The XOR undoes itself, so stepping back
+ * over a delta frame applies it to the current state; stepping back over a
+ * keyframe rebuilds the frame before it from the keyframe before that.
+ *
+ * The oldest frames are dropped a whole keyframe interval at a time once the
+ * ring is full, so the history always begins with a keyframe.
+ */
+class Rewind {
+ public:
+  Rewind();
+
+  /* Forgets the history, as when another program is loaded */
+  void Clear();
+  /* Records the machine's state as the newest frame */
+  void Capture(const Machine& machine);
+  /* Loads the frame before the newest into the machine and forgets the
+   * newest. Returns false, leaving the machine alone, at the oldest frame.
+   */
+  bool StepBack(Machine& machine);
+
+  size_t Frames() const { return m_entries.size(); }
+  size_t BytesUsed() const;
+  const RewindStats& Stats() const { return m_stats; }
+
+ private:
+  struct Entry {
+    size_t offset;
+    size_t size;
+    bool keyframe;
+  };
+
+  void Store(bool keyframe);
+  void Apply(const Entry& entry, uint8_t* state) const;
+  /* Rebuilds the state of the newest entry from the keyframe before it */
+  void Rebuild();
+
+  /* The encoded frames, oldest first, laid out in m_ring */
+  std::vector<uint8_t> m_ring{};
+  std::deque<Entry> m_entries{};
+  size_t m_head{0};
+  /* Frames stored since the last keyframe */
+  int m_since_keyframe{0};
+
+  /* The newest frame's state, and the one being captured */
+  std::vector<uint8_t> m_state{};
+  std::vector<uint8_t> m_next{};
+  std::vector<uint8_t> m_encoded{};
+
+  RewindStats m_stats{};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_REWIND_H_
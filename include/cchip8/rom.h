@@ -5,7 +5,7 @@
 #include <cstdint>
 #include <string>
 
-#define MAX_ROM_SIZE 3584  // 4096 - 512
+#define MAX_ROM_SIZE 65024  // 65536 - 512
 
 namespace cchip8 {
 
@@ -20,6 +20,8 @@ class Rom {
   const std::string& Filename() const { return m_filename; };
   size_t Size() const { return m_romSize; };
   [[nodiscard]] bool Loaded() const { return m_loaded; };
+  /* FNV-1a over the program, to tell save states for it apart */
+  uint64_t Hash() const;
 
  private:
   std::array<uint8_t, MAX_ROM_SIZE> m_data{};
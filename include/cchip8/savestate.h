@@ -0,0 +1,77 @@
+#ifndef CCHIP8_SAVESTATE_H_
+#define CCHIP8_SAVESTATE_H_
+
+#include <cchip8/machine.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#define SAVESTATE_VERSION 1
+/* "C8SS" */
+#define SAVESTATE_MAGIC 0x53533843
+/* magic, version, quirks, a reserved byte, ROM hash, frame, state size and
+ * checksum
+ */
+#define SAVESTATE_HEADER_SIZE (4 + 2 + 1 + 1 + 8 + 8 + 4 + 8)
+#define SAVESTATE_SIZE (SAVESTATE_HEADER_SIZE + Machine::STATE_SIZE)
+/* Slots 1 to 8, on F1 to F8 */
+#define SAVESTATE_SLOTS 8
+
+namespace cchip8 {
+
+/*
+ * A save state is a fixed-size record: the header above followed by the
+ * Machine::SaveState() bytes, all in host byte order. The checksum covers
+ * the header and the state, so a record that was only partly written is
+ * refused rather than loaded. A state only loads for the ROM whose hash it
+ * was saved with and restores the quirks profile it ran under.
+ *
+ * The version is bumped whenever the layout of either part changes.
+ */
+void WriteSaveState(const Machine& machine, uint64_t rom_hash, uint64_t frame,
+                    uint8_t* out);
+/* Loads a record into the machine, leaving it untouched and returning false
+ * if the record is invalid or for another ROM. `frame` is set to the frame
+ * the record was written at.
+ */
+[[nodiscard]] bool ReadSaveState(const uint8_t* in, uint64_t rom_hash,
+                                 Machine& machine, uint64_t& frame);
+
+[[nodiscard]] bool SaveStateToFile(const std::string& filename,
+                                   const Machine& machine, uint64_t rom_hash);
+[[nodiscard]] bool LoadStateFromFile(const std::string& filename,
+                                     uint64_t rom_hash, Machine& machine);
+
+/*
+ * A file of two save state records that is written on every frame, taking
+ * turns between the records so that one is always whole. The file is
+ * mapped into memory where the platform allows, so a write is a copy into
+ * the page cache and survives the process being killed or crashing. It is
+ * not synced to disk, which would cost far more than the frame.
+ */
+class Autosave {
+ public:
+  Autosave() = default;
+  ~Autosave();
+  Autosave(const Autosave&) = delete;
+  Autosave& operator=(const Autosave&) = delete;
+
+  /* Opens or creates the file, sizing it for both records */
+  [[nodiscard]] bool Open(const std::string& filename);
+  bool IsOpen() const { return m_data != nullptr; }
+  void Write(const Machine& machine, uint64_t rom_hash);
+  /* Loads the newer of the records that are whole and for this ROM */
+  [[nodiscard]] bool Restore(uint64_t rom_hash, Machine& machine);
+  void Close();
+
+ private:
+  uint8_t* m_data{nullptr};
+  int m_fd{-1};
+  /* Counts writes, so the newer record can be told apart */
+  uint64_t m_frame{0};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_SAVESTATE_H_
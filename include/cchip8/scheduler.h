@@ -0,0 +1,71 @@
+#ifndef CCHIP8_SCHEDULER_H_
+#define CCHIP8_SCHEDULER_H_
+
+#include <cchip8/timing_history.h>
+
+#include <chrono>
+#include <cstdint>
+
+#define FRAME_RATE 60
+/* How long before a deadline the scheduler stops sleeping and spins. Sleeps
+ * overshoot by tens of microseconds on a quiet Linux host and by more on a
+ * loaded one, so this leaves room for both.
+ */
+#define SCHEDULER_SPIN_MARGIN_US 1000
+#define SCHEDULER_MAX_CATCH_UP 4
+/* Frame periods kept for the percentiles, about a minute at 60 Hz */
+#define SCHEDULER_HISTORY 4096
+
+namespace cchip8 {
+
+/*
+ * Paces frames against absolute deadlines on the steady clock. Each deadline
+ * is the previous one plus the period, not the time the frame happened to
+ * start plus the period, so lateness is never carried into the next frame.
+ *
+ * Frames are waited for with a coarse sleep followed by a spin over the last
+ * SCHEDULER_SPIN_MARGIN_US. When the host falls behind, the frames missed are
+ * reported so they can be run back to back, up to a limit past which they
+ * are dropped and the deadlines start again from now.
+ */
+class FrameScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit FrameScheduler(int rate = FRAME_RATE,
+                          int max_catch_up = SCHEDULER_MAX_CATCH_UP);
+
+  void SetMaxCatchUp(const int frames) {
+    m_max_catch_up = frames > 1 ? frames : 1;
+  }
+  /* Starts the deadlines from now, after which the first frame is one
+   * period away. Called again after a pause, which is not counted as a
+   * frame period.
+   */
+  void Start();
+  /* Blocks until the next deadline and returns the number of frames now
+   * due, at least 1 and at most the catch-up limit
+   */
+  int Wait();
+
+  /* The p-th percentile, 0 to 100, of the measured frame periods in
+   * milliseconds, or 0 before any were measured
+   */
+  double Percentile(double p) const { return m_history.Percentile(p); }
+  uint64_t Dropped() const { return m_dropped; }
+
+ private:
+  Clock::duration m_period;
+  int m_max_catch_up;
+  Clock::time_point m_deadline{};
+  /* When the previous Wait() returned, unset right after Start() */
+  Clock::time_point m_last{};
+  uint64_t m_dropped{0};
+
+  /* The latest frame periods */
+  TimingHistory m_history{SCHEDULER_HISTORY};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_SCHEDULER_H_
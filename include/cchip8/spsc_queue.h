@@ -0,0 +1,48 @@
+#ifndef CCHIP8_SPSC_QUEUE_H_
+#define CCHIP8_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace cchip8 {
+
+/*
+ * A bounded ring for one producer thread and one consumer thread, without
+ * locks. Each side only ever writes its own index, so a push or a pop is a
+ * copy and one release store. The indices count up without wrapping and are
+ * masked into the ring, whose size must be a power of two.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  /* Producer side. Returns false, dropping the item, when the ring is full */
+  bool Push(const T& item) {
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) == N) return false;
+    m_items[head & (N - 1)] = item;
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /* Consumer side. Returns false when the ring is empty. */
+  bool Pop(T& item) {
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) return false;
+    item = m_items[tail & (N - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::array<T, N> m_items{};
+  /* On lines of their own, so the two threads do not share one */
+  alignas(64) std::atomic<size_t> m_head{0};
+  alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_SPSC_QUEUE_H_
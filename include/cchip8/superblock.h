@@ -0,0 +1,88 @@
+#ifndef CCHIP8_SUPERBLOCK_H_
+#define CCHIP8_SUPERBLOCK_H_
+
+#include <cchip8/dispatch.h>
+#include <cchip8/instruction.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define SUPERBLOCK_MAX_LENGTH 64
+#define SUPEROP_MAX_LENGTH 3
+
+namespace cchip8 {
+
+class Machine;
+
+struct SuperOp;
+
+/* Returns the number of instructions executed, which is less than the
+ * op's length when a skip inside it was taken.
+ */
+using SuperOpFn = int (*)(Machine& machine, const SuperOp& op);
+
+/* One step of a superblock: a single instruction, or a fused sequence of up
+ * to SUPEROP_MAX_LENGTH instructions that is executed by one handler.
+ */
+struct SuperOp {
+  SuperOpFn fn{nullptr};
+  uint16_t address{0};
+  uint8_t length{0};
+  std::array<Instruction, SUPEROP_MAX_LENGTH> instructions{0, 0, 0};
+};
+
+/*
+ * A straight-line trace of instructions starting at `address`. It ends at
+ * the first instruction that may change pc or writes to memory, so every
+ * op but the last falls through to the next one.
+ */
+struct Superblock {
+  struct Link {
+    uint16_t pc{0};
+    Superblock* block{nullptr};
+  };
+
+  uint16_t address{0};
+  int length{0};
+  std::vector<SuperOp> ops{};
+  /* The blocks most recently run after this one, keyed by their address */
+  std::array<Link, 2> links{};
+  uint8_t next_link{0};
+};
+
+/*
+ * The superblock tier sits between the plain interpreter and the JIT. It
+ * forms traces from pc, fuses the instruction sequences that are most
+ * frequent in practice into single handlers, and links traces by their
+ * branch targets so that steady-state execution does not go through fetch,
+ * decode or a lookup. Like the JIT, all traces are dropped whenever the
+ * memory's code generation changes. Traces are formed from the handlers for
+ * one quirks profile, fixed at construction.
+ */
+class Superblocks {
+ public:
+  explicit Superblocks(const Quirks quirks);
+
+  /* Returns the ticks left over when the CPU stopped early */
+  int Run(Machine& machine, int ticks);
+  void Flush();
+
+ private:
+  Superblock* Lookup(Memory& memory, const uint16_t pc);
+  Superblock* Next(Memory& memory, Superblock* from, const uint16_t pc);
+  template <typename Quirks>
+  std::unique_ptr<Superblock> Form(Memory& memory, const uint16_t pc);
+
+  std::array<std::unique_ptr<Superblock>, RAM_SIZE> m_blocks{};
+  uint32_t m_generation{0};
+  std::unique_ptr<Superblock> (Superblocks::*m_form)(Memory& memory,
+                                                     const uint16_t pc);
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_SUPERBLOCK_H_
@@ -0,0 +1,61 @@
+#ifndef CCHIP8_THREAD_POOL_H_
+#define CCHIP8_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cchip8 {
+
+/*
+ * A work-stealing thread pool. Every worker has its own queue and takes jobs
+ * from its back; once that is empty it steals from the front of the others,
+ * so long and short jobs even out across the workers without a shared queue.
+ * Workers can optionally be pinned to one core each.
+ */
+class ThreadPool {
+ public:
+  using Job = std::function<void()>;
+
+  ThreadPool(size_t threads, bool pin);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Submit(Job job);
+  /* Blocks until every submitted job has finished */
+  void Wait();
+
+  size_t Size() const { return m_workers.size(); }
+
+ private:
+  struct Queue {
+    std::mutex mutex{};
+    std::deque<Job> jobs{};
+  };
+
+  void Work(size_t index);
+  bool Pop(size_t index, Job& job);
+  bool Steal(size_t index, Job& job);
+
+  std::vector<std::unique_ptr<Queue>> m_queues{};
+  std::vector<std::thread> m_workers{};
+  std::atomic<size_t> m_next{0};
+
+  std::mutex m_mutex{};
+  std::condition_variable m_work_available{};
+  std::condition_variable m_all_done{};
+  size_t m_queued{0};
+  size_t m_pending{0};
+  bool m_stopping{false};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_THREAD_POOL_H_
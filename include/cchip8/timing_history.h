@@ -0,0 +1,36 @@
+#ifndef CCHIP8_TIMING_HISTORY_H_
+#define CCHIP8_TIMING_HISTORY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cchip8 {
+
+/*
+ * A ring of the latest durations measured, in nanoseconds, for reporting
+ * percentiles over a recent window. Once full, each new duration replaces
+ * the oldest.
+ */
+class TimingHistory {
+ public:
+  explicit TimingHistory(const size_t capacity) : m_capacity(capacity) {
+    m_samples.reserve(capacity);
+  }
+
+  void Record(uint64_t nanoseconds);
+
+  /* The p-th percentile, 0 to 100, of the durations held in milliseconds,
+   * or 0 before any were recorded
+   */
+  double Percentile(double p) const;
+
+ private:
+  size_t m_capacity;
+  std::vector<uint64_t> m_samples{};
+  size_t m_next{0};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_TIMING_HISTORY_H_
@@ -0,0 +1,54 @@
+#ifndef CCHIP8_TRIPLE_BUFFER_H_
+#define CCHIP8_TRIPLE_BUFFER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace cchip8 {
+
+/*
+ * Hands the latest of a stream of values from one writer thread to one
+ * reader thread, without locks and without either ever waiting.
+ *
+ * The writer fills the back slot and publishes it by swapping it with the
+ * middle one; the reader takes the middle slot by swapping it with the
+ * front one, which it then reads at leisure. A value published while the
+ * previous one was never taken replaces it, so a slow reader skips values
+ * rather than holding up the writer.
+ */
+template <typename T>
+class TripleBuffer {
+ public:
+  /* Writer side: the slot to fill, then publish */
+  T& Back() { return m_slots[m_back]; }
+  void Publish() {
+    m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) &
+             INDEX;
+  }
+
+  /* Reader side: takes the newest value if one was published since the
+   * last call, returning false otherwise
+   */
+  bool Acquire() {
+    if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+  /* The value last acquired */
+  const T& Front() const { return m_slots[m_front]; }
+
+ private:
+  /* The middle index carries whether it was published and not yet taken */
+  static constexpr uint8_t INDEX = 3;
+  static constexpr uint8_t FRESH = 4;
+
+  std::array<T, 3> m_slots{};
+  alignas(64) uint8_t m_back{0};
+  alignas(64) std::atomic<uint8_t> m_middle{1};
+  alignas(64) uint8_t m_front{2};
+};
+
+}  // namespace cchip8
+
+#endif  // CCHIP8_TRIPLE_BUFFER_H_
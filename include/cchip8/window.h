@@ -3,11 +3,16 @@
 
 #include <SDL.h>
 #include <cchip8/display.h>
-#include <cchip8/memory.h>
+#include <cchip8/framebuffer.h>
 #include <cchip8/menu.h>
 
-#define WINDOW_HEIGHT 32
-#define WINDOW_WIDTH 64
+#include <cstdint>
+
+/* The window opens at WINDOW_SCALE times the low resolution display and
+ * can then be resized freely, down to one window pixel per display pixel
+ */
+#define WINDOW_HEIGHT DISPLAY_HEIGHT
+#define WINDOW_WIDTH DISPLAY_WIDTH
 #define WINDOW_SCALE 10
 #define WINDOW_TITLE "CChip8"
 
@@ -16,11 +21,19 @@ namespace cchip8 {
 class Window {
  public:
   bool running{false};
+  /* Set when what was shown has been lost, as when the window is resized,
+   * so the next frame has to be drawn even if it did not change
+   */
+  bool stale{true};
 
   [[nodiscard]] bool Init();
 
-  void Draw(const Memory& memory);
-  void DrawMenu(const Memory& memory);
+  /* Brings the display up to date with the rows of the frame that changed,
+   * bit y for row y
+   */
+  void Update(const Framebuffer& vram, uint64_t rows);
+  void Draw();
+  void DrawMenu();
   void HandleEvent(const SDL_Event& event);
   void HandlePauseEvent(const SDL_Event& event);
   void Quit();
@@ -28,13 +41,16 @@ class Window {
   void Clear();
 
  private:
-  void DrawDisplay(const Memory& memory);
+  void DrawDisplay();
   void Render();
 
   Display m_display{};
   Menu m_menu{};
   SDL_Window* m_window = nullptr;
   SDL_Renderer* m_renderer = nullptr;
+  /* The output size in pixels as of the last frame drawn */
+  int m_width{WINDOW_WIDTH * WINDOW_SCALE};
+  int m_height{WINDOW_HEIGHT * WINDOW_SCALE};
 };
 
 }  // namespace cchip8
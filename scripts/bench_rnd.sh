@@ -0,0 +1,23 @@
+# RND throughput: runs roms/bench/rnd.ch8, a loop that is 80% Cxkk, and the
+# RNG-heavy bundled ROMs on the interpreter at 100 instructions per frame,
+# and prints millions of instructions per second for each.
+#
+# Usage: scripts/bench_rnd.sh [path/to/chip8-batch]
+#
+# To compare before and after a change to RND, build chip8-batch at both
+# revisions and run this against each binary. Builds that skip idle loops
+# are told not to, so every tick is interpreted in both.
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+batch=${1:-$root/bin/chip8-batch}
+config=ipf=100,backend=interpreter
+if "$batch" --help | grep -q "idle (0"; then
+  config=$config,idle=0
+fi
+
+"$batch" --threads 1 --frames 20000 --config "$config" \
+  "$root/roms/bench/rnd.ch8" "$root/roms/tetris.ch8" \
+  "$root/roms/invaders.ch8" "$root/roms/brix.ch8" |
+  sed -n 's/.*"rom":"\([^"]*\)".*"ips":\([0-9]*\).*/\1 \2/p' |
+  awk '{ printf "%-28s %8.2f MIPS\n", $1, $2 / 1e6 }' | sort
@@ -0,0 +1,433 @@
+#include <cchip8/lockstep.h>
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <cchip8/thread_pool.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void usage() {
+  std::cout
+      << "Usage: chip8-batch [options] rom.ch8...\n"
+      << "Runs every ROM under every parameter set headless and prints one\n"
+      << "JSON line per run.\n"
+      << "Options:\n"
+      << "  --frames N      Frames to run each combination for (default 600)\n"
+      << "  --config SPEC   A parameter set, e.g. \"ipf=20,backend=jit\".\n"
+      << "                  Keys: ipf, backend (interpreter, superblock,\n"
+      << "                  jit), seed, idle (0 interprets idle loops\n"
+      << "                  instead of skipping them), quirks (chip8,\n"
+      << "                  schip, modern). May be repeated.\n"
+      << "  --hash-every N  Record the frame hash every N frames (default 60)\n"
+      << "  --roms FILE     Read ROM paths from FILE, one per line\n"
+      << "  --threads N     Worker threads (default: one per core)\n"
+      << "  --no-pin        Do not pin worker threads to cores\n"
+      << "  --lockstep N    Instead, run each ROM as N lockstep lanes with\n"
+      << "                  their own seeds and keypad input, and compare\n"
+      << "                  the aggregate IPS with one scalar core\n"
+      << "  --verify        With --lockstep, also replay every lane on a\n"
+      << "                  scalar core and fail if any lane differs\n"
+      << "  -h, --help      Show this message" << std::endl;
+}
+
+struct Config {
+  std::string spec{"default"};
+  int ipf{TICKS_PER_FRAME};
+  cchip8::Backend backend{cchip8::Backend::Interpreter};
+  uint64_t seed{DEFAULT_SEED};
+  bool idle_skip{true};
+  cchip8::Quirks quirks{cchip8::Quirks::Modern};
+};
+
+struct Run {
+  const cchip8::Rom* rom;
+  const Config* config;
+};
+
+/* Takes the whole of `text` as a number in [min, max], in decimal or, with
+ * a 0x prefix, hex. Returns false instead of throwing on anything else.
+ */
+bool ParseNumber(const std::string& text, uint64_t& value,
+                 const uint64_t min = 0, const uint64_t max = UINT64_MAX) {
+  /* stoull would skip spaces and take a sign, wrapping negative numbers */
+  if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0])) == 0) {
+    return false;
+  }
+  try {
+    size_t used = 0;
+    value = std::stoull(text, &used, 0);
+    return used == text.size() && value >= min && value <= max;
+  } catch (const std::logic_error&) {
+    return false;
+  }
+}
+
+bool ParseConfig(const std::string& spec, Config& config) {
+  config.spec = spec;
+  std::stringstream stream(spec);
+  std::string pair;
+  while (std::getline(stream, pair, ',')) {
+    auto equals = pair.find('=');
+    if (equals == std::string::npos) {
+      std::cerr << "Expected key=value in config: " << pair << std::endl;
+      return false;
+    }
+    auto key = pair.substr(0, equals);
+    auto value = pair.substr(equals + 1);
+    auto invalid = [&] {
+      std::cerr << "Invalid value in config: " << pair << std::endl;
+      return false;
+    };
+    uint64_t number = 0;
+    if (key == "ipf") {
+      if (!ParseNumber(value, number, 1, INT32_MAX)) return invalid();
+      config.ipf = static_cast<int>(number);
+    } else if (key == "seed") {
+      if (!ParseNumber(value, number)) return invalid();
+      config.seed = number;
+    } else if (key == "idle") {
+      if (!ParseNumber(value, number, 0, 1)) return invalid();
+      config.idle_skip = number != 0;
+    } else if (key == "quirks") {
+      if (!cchip8::ParseQuirks(value, config.quirks)) {
+        std::cerr << "Unknown quirks profile: " << value << std::endl;
+        return false;
+      }
+    } else if (key == "backend" && value == "interpreter") {
+      config.backend = cchip8::Backend::Interpreter;
+    } else if (key == "backend" && value == "superblock") {
+      config.backend = cchip8::Backend::Superblock;
+    } else if (key == "backend" && value == "jit") {
+      config.backend = cchip8::Backend::Jit;
+    } else {
+      std::cerr << "Unknown config setting: " << pair << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string Escape(const std::string& text) {
+  std::string escaped;
+  for (auto c : text) {
+    if (c == '"' || c == '\\') escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+std::string Hex(uint64_t value, int width) {
+  std::stringstream stream;
+  stream << std::hex << std::setw(width) << std::setfill('0') << value;
+  return stream.str();
+}
+
+struct Result {
+  std::string line;
+  uint64_t instructions{0};
+  /* False when --verify found a lockstep lane that differs from its
+   * scalar replay
+   */
+  bool verified{true};
+};
+
+/* Everything a run touches lives in its own Machine, so runs share nothing
+ * but the read-only ROM data. A run ends early when the program exits or
+ * faults, and only the frames and instructions it got through are counted.
+ */
+Result Execute(const Run& run, int frames, int hash_every) {
+  cchip8::Machine machine;
+  std::vector<uint64_t> hashes;
+  bool ok = machine.Load(*run.rom) && machine.SetBackend(run.config->backend);
+  machine.cpu.Seed(run.config->seed);
+  machine.SetIdleSkip(run.config->idle_skip);
+  machine.SetQuirks(run.config->quirks);
+
+  auto start = std::chrono::steady_clock::now();
+  auto ran = 0;
+  while (ok && ran < frames && !machine.cpu.exited) {
+    machine.RunFrame(run.config->ipf);
+    ++ran;
+    ok = !machine.cpu.Faulted();
+    if (ran % hash_every == 0) hashes.push_back(machine.memory.FrameHash());
+  }
+  if (ran % hash_every != 0) hashes.push_back(machine.memory.FrameHash());
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  const auto instructions = machine.stats.Executed();
+
+  const auto& cpu = machine.cpu;
+  std::stringstream line;
+  line << "{\"rom\":\"" << Escape(run.rom->Filename()) << "\",\"config\":\""
+       << Escape(run.config->spec) << "\",\"ok\":" << (ok ? "true" : "false")
+       << ",\"frames\":" << ran << ",\"instructions\":" << instructions
+       << ",\"seconds\":" << elapsed.count() << ",\"ips\":"
+       << static_cast<uint64_t>(instructions / elapsed.count())
+       << ",\"skipped\":" << machine.stats.skipped
+       << ",\"halted\":" << machine.stats.halted
+       << ",\"stopped\":" << machine.stats.stopped
+       << ",\"exited\":" << (cpu.exited ? "true" : "false")
+       << ",\"pc\":" << cpu.pc << ",\"I\":" << cpu.I
+       << ",\"sp\":" << static_cast<int>(cpu.sp)
+       << ",\"delay\":" << static_cast<int>(cpu.t_delay)
+       << ",\"sound\":" << static_cast<int>(cpu.t_sound) << ",\"registers\":[";
+  for (size_t i = 0; i < cpu.registers.size(); ++i) {
+    line << (i > 0 ? "," : "") << static_cast<int>(cpu.registers.at(i));
+  }
+  line << "],\"frame_hashes\":[";
+  for (size_t i = 0; i < hashes.size(); ++i) {
+    line << (i > 0 ? "," : "") << '"' << Hex(hashes.at(i), 16) << '"';
+  }
+  line << "]";
+  if (cpu.Faulted()) {
+    line << ",\"fault\":{\"kind\":\"" << cchip8::FaultName(cpu.fault.kind)
+         << "\",\"pc\":" << cpu.fault.pc << ",\"opcode\":" << cpu.fault.opcode
+         << ",\"address\":" << cpu.fault.address << "}";
+  }
+  line << "}";
+  return Result{line.str(), instructions, true};
+}
+
+/* A single random key, or none, as a keypad bitmask */
+uint16_t RandomKeypad(uint32_t& state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return (state & 0x10) != 0 ? 1u << (state & 0x0F) : 0;
+}
+
+/* Whether a lockstep lane is in the same state as a scalar Machine. RAM is
+ * only compared when asked, as it is 64 KiB per lane.
+ */
+bool SameLane(const cchip8::Lockstep& lockstep, size_t lane,
+              const cchip8::Machine& machine, bool compare_ram) {
+  const auto cpu = lockstep.LaneCpu(lane);
+  const auto& memory = lockstep.LaneMemory(lane);
+  return cpu.SameState(machine.cpu) &&
+         lockstep.Faulted(lane) == machine.cpu.Faulted() &&
+         cpu.fault.kind == machine.cpu.fault.kind &&
+         memory.FrameHash() == machine.memory.FrameHash() &&
+         (!compare_ram || memory.ram == machine.memory.ram);
+}
+
+/* Runs `lanes` instances of a ROM through the lockstep engine, then a
+ * single one on the scalar core for the same number of frames, and reports
+ * how many scalar cores the lockstep run was worth. With `verify`, every
+ * lane is also replayed on a scalar Machine of its own with the same seed
+ * and keys, and compared with it after every frame.
+ */
+Result ExecuteLockstep(const cchip8::Rom& rom, const Config& config,
+                       size_t lanes, int frames, bool verify) {
+  cchip8::Lockstep lockstep(rom, lanes, config.quirks);
+  std::vector<uint32_t> states(lanes);
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    lockstep.Seed(lane, config.seed + lane);
+    states.at(lane) = lane + 1;
+  }
+
+  bool ok = true;
+  std::vector<std::unique_ptr<cchip8::Machine>> replicas;
+  for (size_t lane = 0; verify && lane < lanes; ++lane) {
+    auto replica = std::make_unique<cchip8::Machine>();
+    ok &= replica->Load(rom) && replica->SetBackend(config.backend);
+    replica->cpu.Seed(config.seed + lane);
+    replica->SetIdleSkip(config.idle_skip);
+    replica->SetQuirks(config.quirks);
+    replicas.push_back(std::move(replica));
+  }
+  std::vector<uint8_t> mismatched(lanes);
+
+  std::chrono::duration<double> elapsed{0};
+  size_t max_groups = 0;
+  for (auto frame = 0; ok && frame < frames; ++frame) {
+    /* Every lane switches keys every eight frames */
+    for (size_t lane = 0; frame % 8 == 0 && lane < lanes; ++lane) {
+      const auto keys = RandomKeypad(states.at(lane));
+      lockstep.SetKeypad(lane, keys);
+      if (verify) replicas.at(lane)->input.SetKeys(keys);
+    }
+    auto start = std::chrono::steady_clock::now();
+    lockstep.RunFrame(config.ipf);
+    elapsed += std::chrono::steady_clock::now() - start;
+    max_groups = std::max(max_groups, lockstep.Groups());
+
+    const bool last = frame + 1 == frames;
+    for (size_t lane = 0; verify && lane < lanes; ++lane) {
+      if (mismatched.at(lane) != 0) continue;
+      auto& replica = *replicas.at(lane);
+      replica.RunFrame(config.ipf);
+      mismatched.at(lane) = !SameLane(lockstep, lane, replica, last);
+    }
+  }
+
+  cchip8::Machine machine;
+  ok &= machine.Load(rom) && machine.SetBackend(config.backend);
+  machine.cpu.Seed(config.seed);
+  machine.SetIdleSkip(config.idle_skip);
+  machine.SetQuirks(config.quirks);
+  auto scalar_start = std::chrono::steady_clock::now();
+  for (auto frame = 0; ok && frame < frames; ++frame) {
+    machine.RunFrame(config.ipf);
+  }
+  std::chrono::duration<double> scalar_elapsed =
+      std::chrono::steady_clock::now() - scalar_start;
+
+  size_t faulted = 0;
+  uint64_t instructions = 0;
+  for (size_t lane = 0; lane < lanes; ++lane) {
+    faulted += lockstep.Faulted(lane);
+    instructions += lockstep.Executed(lane);
+  }
+  const auto mismatches =
+      std::count(mismatched.begin(), mismatched.end(), uint8_t{1});
+  const bool passed = ok && mismatches == 0;
+  ok = passed && faulted == 0;
+
+  auto ips = instructions / elapsed.count();
+  auto scalar_ips = machine.stats.Executed() / scalar_elapsed.count();
+  std::stringstream line;
+  line << "{\"rom\":\"" << Escape(rom.Filename()) << "\",\"config\":\""
+       << Escape(config.spec) << "\",\"ok\":" << (ok ? "true" : "false")
+       << ",\"lanes\":" << lanes << ",\"frames\":" << frames
+       << ",\"instructions\":" << instructions
+       << ",\"seconds\":" << elapsed.count()
+       << ",\"ips\":" << static_cast<uint64_t>(ips)
+       << ",\"scalar_ips\":" << static_cast<uint64_t>(scalar_ips)
+       << ",\"equivalent_cores\":" << ips / scalar_ips
+       << ",\"max_groups\":" << max_groups
+       << ",\"faulted_lanes\":" << faulted;
+  if (verify) line << ",\"mismatched_lanes\":" << mismatches;
+  line << "}";
+  return Result{line.str(), instructions, passed};
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = 600;
+  int hash_every = 60;
+  size_t threads = std::thread::hardware_concurrency();
+  bool pin = true;
+  size_t lanes = 0;
+  bool verify = false;
+  std::vector<std::string> files{};
+  std::vector<Config> configs{};
+
+  /* Reads the value of a numeric option, which must be at least 1 */
+  auto count = [&](int& i, uint64_t& value) {
+    if (ParseNumber(argv[i + 1], value, 1, INT32_MAX)) {
+      ++i;
+      return true;
+    }
+    std::cerr << "Invalid value for " << argv[i] << ": " << argv[i + 1]
+              << std::endl;
+    return false;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    uint64_t value = 0;
+    if (arg == "--help" || arg == "-h") {
+      usage();
+      return EXIT_SUCCESS;
+    } else if (arg == "--frames" && has_value) {
+      if (!count(i, value)) return EXIT_FAILURE;
+      frames = static_cast<int>(value);
+    } else if (arg == "--hash-every" && has_value) {
+      if (!count(i, value)) return EXIT_FAILURE;
+      hash_every = static_cast<int>(value);
+    } else if (arg == "--threads" && has_value) {
+      if (!count(i, value)) return EXIT_FAILURE;
+      threads = value;
+    } else if (arg == "--lockstep" && has_value) {
+      if (!count(i, value)) return EXIT_FAILURE;
+      lanes = value;
+    } else if (arg == "--verify") {
+      verify = true;
+    } else if (arg == "--no-pin") {
+      pin = false;
+    } else if (arg == "--config" && has_value) {
+      Config config;
+      if (!ParseConfig(argv[++i], config)) return EXIT_FAILURE;
+      configs.push_back(config);
+    } else if (arg == "--roms" && has_value) {
+      std::ifstream list(argv[++i]);
+      std::string line;
+      while (std::getline(list, line)) {
+        if (!line.empty()) files.push_back(line);
+      }
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty() || frames <= 0 || hash_every <= 0) {
+    usage();
+    return EXIT_FAILURE;
+  }
+  if (configs.empty()) configs.emplace_back();
+
+  std::vector<cchip8::Rom> roms(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!roms.at(i).FromFile(files.at(i))) {
+      std::cerr << "Could not load " << files.at(i) << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (lanes > 0) {
+    bool verified = true;
+    for (const auto& rom : roms) {
+      for (const auto& config : configs) {
+        auto result = ExecuteLockstep(rom, config, lanes, frames, verify);
+        std::cout << result.line << std::endl;
+        verified &= result.verified;
+      }
+    }
+    if (!verified) {
+      std::cerr << "Lockstep lanes differ from the scalar core" << std::endl;
+    }
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  std::mutex output;
+  uint64_t instructions = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    cchip8::ThreadPool pool(threads, pin);
+    threads = pool.Size();
+    for (const auto& rom : roms) {
+      for (const auto& config : configs) {
+        Run run{&rom, &config};
+        pool.Submit([run, frames, hash_every, &output, &instructions] {
+          auto result = Execute(run, frames, hash_every);
+          std::lock_guard<std::mutex> lock(output);
+          std::cout << result.line << std::endl;
+          instructions += result.instructions;
+        });
+      }
+    }
+    pool.Wait();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::cerr << roms.size() * configs.size() << " runs on " << threads
+            << " threads in " << elapsed.count() << " s, "
+            << static_cast<uint64_t>(instructions / elapsed.count())
+            << " instructions per second" << std::endl;
+  return EXIT_SUCCESS;
+}
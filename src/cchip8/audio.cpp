@@ -1,49 +1,146 @@
 #include <cchip8/audio.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <string>
 
 namespace cchip8 {
 
 bool Audio::Init() {
+  for (auto i = 0; i < AUDIO_WAVETABLE_SIZE; ++i) {
+    const auto angle = 2.0 * M_PI * i / AUDIO_WAVETABLE_SIZE;
+    m_wavetable[i] = static_cast<int8_t>(
+        std::lround(std::sin(angle) * AUDIO_MAX_VOLUME));
+  }
+  m_increment = static_cast<uint32_t>(
+      std::llround(m_frequency * 4294967296.0 / AUDIO_SAMPLE_RATE));
+
+  if (m_buffer_frames > 0) {
+    SDL_SetHint(SDL_HINT_AUDIO_DEVICE_SAMPLE_FRAMES,
+                std::to_string(m_buffer_frames).c_str());
+  }
   m_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_OUTPUT, &m_spec,
                                        Callback, this);
   if (m_stream == nullptr) {
     SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
     return false;
   }
+  /* The stream runs from now on and plays silence while the gate is shut */
+  SDL_ResumeAudioDevice(SDL_GetAudioStreamDevice(m_stream));
   return true;
 }
 
-void Audio::Reset() {
-  PauseTone();
-  m_frequency = 440.0;
-  m_volume = 32.0;
-  m_wave_pos = 0.0;
-  m_audio_buffer.fill(0);
+void Audio::setBufferFrames(const int frames) {
+  m_buffer_frames =
+      std::clamp(frames, AUDIO_MIN_DEVICE_FRAMES, AUDIO_MAX_DEVICE_FRAMES);
 }
 
-void Audio::StartTone() {
-  SDL_ResumeAudioDevice(SDL_GetAudioStreamDevice(m_stream));
+void Audio::setVolume(const int volume) {
+  m_volume = std::clamp(volume, 0, AUDIO_MAX_VOLUME);
 }
 
-void Audio::PauseTone() {
-  SDL_PauseAudioDevice(SDL_GetAudioStreamDevice(m_stream));
+AudioStats Audio::Stats() const {
+  AudioStats stats;
+  stats.callbacks = m_callbacks.load(std::memory_order_relaxed);
+  stats.samples = m_samples.load(std::memory_order_relaxed);
+  stats.underruns = m_underruns.load(std::memory_order_relaxed);
+  stats.callback_time =
+      std::chrono::nanoseconds(m_callback_ns.load(std::memory_order_relaxed));
+  stats.callback_max = std::chrono::nanoseconds(
+      m_callback_max_ns.load(std::memory_order_relaxed));
+  stats.queued_total = m_queued_total.load(std::memory_order_relaxed);
+  stats.queued_max = m_queued_max.load(std::memory_order_relaxed);
+  return stats;
 }
 
-bool Audio::IsPaused() const {
-  return SDL_AudioDevicePaused(SDL_GetAudioStreamDevice(m_stream)) == SDL_TRUE;
+void Audio::QueueEdge(const uint64_t time, const bool on) {
+  if (!m_edges.Push(SoundEdge{time, on})) {
+    SDL_Log("Sound edge queue full, dropped an edge");
+  }
 }
 
-double Audio::GetSample() const {
-  return std::sin(m_wave_pos) * m_volume + AUDIO_8BIT_BIAS;
+bool Audio::NextEdge() {
+  if (!m_edges.Pop(m_edge)) return false;
+  const auto at = static_cast<int64_t>(m_edge.time) - m_offset;
+  const auto now = static_cast<int64_t>(m_sample);
+  if (!m_synced || at < now - AUDIO_EDGE_DELAY ||
+      at > now + (4 * AUDIO_EDGE_DELAY)) {
+    m_offset = static_cast<int64_t>(m_edge.time) - (now + AUDIO_EDGE_DELAY);
+    m_synced = true;
+  }
+  /* An edge that is a little late is applied at once */
+  if (static_cast<int64_t>(m_edge.time) - m_offset < now) {
+    Count<uint64_t>(m_underruns, 1);
+  }
+  m_edge_sample = static_cast<uint64_t>(
+      std::max(static_cast<int64_t>(m_edge.time) - m_offset, now));
+  return true;
+}
+
+/* Renders in spans between edges, so the gate is only looked at where it
+ * can change
+ */
+void Audio::Fill(uint8_t *out, int samples) {
+  const auto muted = m_muted.load(std::memory_order_relaxed);
+  const auto volume = m_volume.load(std::memory_order_relaxed);
+  while (samples > 0) {
+    if (!m_has_edge) m_has_edge = NextEdge();
+    if (m_has_edge && m_edge_sample <= m_sample) {
+      m_gate = m_edge.on;
+      /* Starting at the table's zero crossing avoids a click */
+      if (m_gate) m_phase = 0;
+      m_has_edge = false;
+      continue;
+    }
+    auto span = samples;
+    if (m_has_edge) {
+      span = static_cast<int>(
+          std::min<uint64_t>(span, m_edge_sample - m_sample));
+    }
+    if (m_gate && !muted) {
+      for (auto i = 0; i < span; ++i) {
+        const auto level = m_wavetable[m_phase >> (32 - AUDIO_WAVETABLE_BITS)];
+        out[i] = static_cast<uint8_t>(AUDIO_8BIT_BIAS +
+                                      (level * volume) / AUDIO_MAX_VOLUME);
+        m_phase += m_increment;
+      }
+    } else {
+      std::fill(out, out + span, AUDIO_8BIT_BIAS);
+    }
+    out += span;
+    samples -= span;
+    m_sample += span;
+  }
 }
 
-void Audio::IncrementWavePosition() {
-  m_wave_pos += (m_frequency * 2.0 * M_PI) / AUDIO_SAMPLE_RATE;
+void Audio::Render(SDL_AudioStream *stream, int samples) {
+  const auto start = std::chrono::steady_clock::now();
+  Count<uint64_t>(m_samples, samples);
+  while (samples > 0) {
+    const auto chunk = std::min(samples, AUDIO_BUFFER_SIZE);
+    Fill(m_audio_buffer.data(), chunk);
+    SDL_PutAudioStreamData(stream, m_audio_buffer.data(), chunk);
+    samples -= chunk;
+  }
+  /* One byte to a sample, with 8-bit mono */
+  const auto queued =
+      static_cast<uint64_t>(std::max(SDL_GetAudioStreamQueued(stream), 0));
+  Count(m_queued_total, queued);
+  Max(m_queued_max, queued);
+  const int64_t elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+  Count(m_callback_ns, elapsed);
+  Max(m_callback_max_ns, elapsed);
+  Count<uint64_t>(m_callbacks, 1);
 }
 
 void Audio::Quit() {
   if (m_stream != nullptr) SDL_DestroyAudioStream(m_stream);
+  m_stream = nullptr;
   SDL_QuitSubSystem(SDL_INIT_AUDIO);
 }
 
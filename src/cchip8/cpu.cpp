@@ -3,10 +3,11 @@
 #include <cchip8/input.h>
 #include <cchip8/instruction.h>
 #include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/random.h>
 
 #include <iomanip>
 #include <iostream>
-#include <random>
 
 namespace cchip8 {
 
@@ -17,15 +18,63 @@ void Cpu::Reset() {
   sp = 0;
   t_delay = 0;
   t_sound = 0;
+  halted = false;
+  exited = false;
+  fault = GuestFault{};
+  Seed(seed);
 }
 
-uint8_t Cpu::RandomByte() const {
-  std::random_device rd;
-  std::mt19937 rng(rd());
-  std::uniform_int_distribution<int> distribution(0, 0xFF);
-  return distribution(rng);
+/* Called from an instruction before it has any effect, once pc has already
+ * moved past it
+ */
+void Cpu::RaiseFault(const FaultKind kind, const uint16_t opcode,
+                     const uint16_t address) {
+  pc -= 2;
+  if (fault.kind == FaultKind::None) {
+    fault = GuestFault{kind, pc, opcode, address};
+  }
+}
+
+const char *FaultName(const FaultKind kind) {
+  switch (kind) {
+    case FaultKind::None:
+      return "none";
+    case FaultKind::Fetch:
+      return "fetch";
+    case FaultKind::Ram:
+      return "ram";
+    case FaultKind::StackOverflow:
+      return "stack overflow";
+    case FaultKind::StackUnderflow:
+      return "stack underflow";
+  }
+  return "unknown";
 }
 
+bool Cpu::SameState(const Cpu &other) const {
+  return registers == other.registers && I == other.I && pc == other.pc &&
+         sp == other.sp && t_delay == other.t_delay &&
+         t_sound == other.t_sound && rng == other.rng &&
+         halted == other.halted && exited == other.exited;
+}
+
+void Cpu::Seed(const uint64_t value) {
+  seed = value;
+  rng = SeedRandom(value);
+}
+
+/* Moves pc past the next instruction, which is four bytes long if it is
+ * XO-CHIP's F000 nnnn
+ */
+void Cpu::Skip(const Memory &memory) {
+  const bool long_load = memory.ram[MemoryPolicy::Ram(pc)] == 0xF0 &&
+                         memory.ram[MemoryPolicy::Ram(pc + 1)] == 0x00;
+  pc += long_load ? 4 : 2;
+}
+
+/* The top bits of xoshiro128** are its strongest */
+uint8_t Cpu::RandomByte() { return NextRandom(rng) >> 24; }
+
 /*
  * Descriptions from http://devernay.free.fr/hacks/chip8/C8TECH10.HTM
  */
@@ -48,7 +97,61 @@ void Cpu::CLS(Memory &memory) { memory.ClearVram(); };
  * The interpreter sets the program counter to the address at the top of the
  * stack, then subtracts 1 from the stack pointer.
  */
-void Cpu::RET(Memory &memory) { pc = memory.stack.at(sp--); };
+void Cpu::RET(Memory &memory) {
+  if (!MemoryPolicy::CanReturn(sp)) {
+    return RaiseFault(FaultKind::StackUnderflow, 0x00EE, sp);
+  }
+  pc = memory.stack[MemoryPolicy::Stack(sp--)];
+};
+
+/*
+ * SUPER-CHIP instructions, from the same document's section 3.2. Scrolling
+ * moves the screen by pixels of the current resolution.
+ */
+
+/* 00Cn - SCD nibble
+ * Scroll display n lines down.
+ */
+void Cpu::SCD(const Instruction &instruction, Memory &memory) {
+  memory.vram.ScrollDown(instruction.n());
+};
+
+/* 00Dn - SCU nibble
+ * Scroll display n lines up. From XO-CHIP.
+ */
+void Cpu::SCU(const Instruction &instruction, Memory &memory) {
+  memory.vram.ScrollUp(instruction.n());
+};
+
+/* 00FB - SCR
+ * Scroll display 4 pixels right.
+ */
+void Cpu::SCR(Memory &memory) { memory.vram.ScrollRight(4); };
+
+/* 00FC - SCL
+ * Scroll display 4 pixels left.
+ */
+void Cpu::SCL(Memory &memory) { memory.vram.ScrollLeft(4); };
+
+/* 00FD - EXIT
+ * Exit interpreter.
+ *
+ * The CPU stops with pc left on this instruction.
+ */
+void Cpu::EXIT() {
+  pc -= 2;
+  exited = true;
+};
+
+/* 00FE - LOW
+ * Disable extended screen mode.
+ */
+void Cpu::LOW(Memory &memory) { memory.vram.SetHires(false); };
+
+/* 00FF - HIGH
+ * Enable extended screen mode for full-screen graphics.
+ */
+void Cpu::HIGH(Memory &memory) { memory.vram.SetHires(true); };
 
 /*
  * 1nnn - JP addr
@@ -65,7 +168,12 @@ void Cpu::JP(const Instruction &instruction) { pc = instruction.addr(); };
  * the top of the stack. The PC is then set to nnn.
  */
 void Cpu::CALL(const Instruction &instruction, Memory &memory) {
-  memory.stack.at(++sp) = pc;
+  const uint8_t next = sp + 1;
+  if (!MemoryPolicy::InStack(next)) {
+    return RaiseFault(FaultKind::StackOverflow, instruction.instruction(),
+                      next);
+  }
+  memory.stack[MemoryPolicy::Stack(++sp)] = pc;
   pc = instruction.addr();
 };
 
@@ -75,9 +183,9 @@ void Cpu::CALL(const Instruction &instruction, Memory &memory) {
  * The interpreter compares register Vx to kk, and if they are equal,
  * increments the program counter by 2.
  */
-void Cpu::SE_VX_KK(const Instruction &instruction) {
-  if (registers.at(instruction.x()) == instruction.kk()) {
-    pc += 2;
+void Cpu::SE_VX_KK(const Instruction &instruction, const Memory &memory) {
+  if (registers[instruction.x()] == instruction.kk()) {
+    Skip(memory);
   }
 };
 
@@ -87,9 +195,9 @@ void Cpu::SE_VX_KK(const Instruction &instruction) {
  * The interpreter compares register Vx to kk, and if they are not equal,
  * increments the program counter by 2.
  */
-void Cpu::SNE_VX_KK(const Instruction &instruction) {
-  if (registers.at(instruction.x()) != instruction.kk()) {
-    pc += 2;
+void Cpu::SNE_VX_KK(const Instruction &instruction, const Memory &memory) {
+  if (registers[instruction.x()] != instruction.kk()) {
+    Skip(memory);
   }
 };
 
@@ -99,9 +207,51 @@ void Cpu::SNE_VX_KK(const Instruction &instruction) {
  * The interpreter compares register Vx to register Vy, and if they are equal,
  * increments the program counter by 2.
  */
-void Cpu::SE_VX_VY(const Instruction &instruction) {
-  if (registers.at(instruction.x()) == registers.at(instruction.y())) {
-    pc += 2;
+void Cpu::SE_VX_VY(const Instruction &instruction, const Memory &memory) {
+  if (registers[instruction.x()] == registers[instruction.y()]) {
+    Skip(memory);
+  }
+};
+
+/*
+ * XO-CHIP instructions, from the XO-CHIP specification at
+ * https://johnearnest.github.io/Octo/docs/XO-ChipSpecification.html
+ */
+
+/* 5xy2 - LD [I], Vx-Vy
+ * Store registers Vx through Vy in memory starting at location I.
+ *
+ * The range is inclusive and is stored in reverse when x is greater than y.
+ * I is left unchanged.
+ */
+void Cpu::LD_I_VX_VY(const Instruction &instruction, Memory &memory) {
+  const auto x = instruction.x();
+  const auto y = instruction.y();
+  const auto count = (x > y ? x - y : y - x) + 1;
+  if (!MemoryPolicy::InRam(I, count)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), I);
+  }
+  const auto step = x > y ? -1 : 1;
+  for (auto i = 0; i < count; ++i) {
+    memory.Write(MemoryPolicy::Ram(I + i), registers[x + (i * step)]);
+  }
+};
+
+/* 5xy3 - LD Vx-Vy, [I]
+ * Read registers Vx through Vy from memory starting at location I.
+ *
+ * The counterpart of 5xy2.
+ */
+void Cpu::LD_VX_VY_I(const Instruction &instruction, Memory &memory) {
+  const auto x = instruction.x();
+  const auto y = instruction.y();
+  const auto count = (x > y ? x - y : y - x) + 1;
+  if (!MemoryPolicy::InRam(I, count)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), I);
+  }
+  const auto step = x > y ? -1 : 1;
+  for (auto i = 0; i < count; ++i) {
+    registers[x + (i * step)] = memory.ram[MemoryPolicy::Ram(I + i)];
   }
 };
 
@@ -111,7 +261,7 @@ void Cpu::SE_VX_VY(const Instruction &instruction) {
  * The interpreter puts the value kk into register Vx.
  */
 void Cpu::LD_VX_KK(const Instruction &instruction) {
-  registers.at(instruction.x()) = instruction.kk();
+  registers[instruction.x()] = instruction.kk();
 };
 
 /* 7xkk - ADD Vx, byte
@@ -120,7 +270,7 @@ void Cpu::LD_VX_KK(const Instruction &instruction) {
  * Adds the value kk to the value of register Vx, then stores the result in Vx.
  */
 void Cpu::ADD_VX_KK(const Instruction &instruction) {
-  registers.at(instruction.x()) += instruction.kk();
+  registers[instruction.x()] += instruction.kk();
 };
 
 /* 8xy0 - LD Vx, Vy
@@ -129,17 +279,19 @@ void Cpu::ADD_VX_KK(const Instruction &instruction) {
  * Stores the value of register Vy in register Vx.
  */
 void Cpu::LD_VX_VY(const Instruction &instruction) {
-  registers.at(instruction.x()) = registers.at(instruction.y());
+  registers[instruction.x()] = registers[instruction.y()];
 };
 
 /* 8xy1 - OR Vx, Vy
  * Set Vx = Vx OR Vy.
  *
  * Performs a bitwise OR on the values of Vx and Vy, then stores the result in
- * Vx.
+ * Vx. The COSMAC VIP also resets VF, as do AND and XOR.
  */
+template <typename Quirks>
 void Cpu::OR_VX_VY(const Instruction &instruction) {
-  registers.at(instruction.x()) |= registers.at(instruction.y());
+  registers[instruction.x()] |= registers[instruction.y()];
+  if constexpr (Quirks::vf_reset) registers[Registers::VF] = 0;
 };
 
 /* 8xy2 - AND Vx, Vy
@@ -148,8 +300,10 @@ void Cpu::OR_VX_VY(const Instruction &instruction) {
  * Performs a bitwise AND on the values of Vx and Vy, then stores the result
  * in Vx.
  */
+template <typename Quirks>
 void Cpu::AND_VX_VY(const Instruction &instruction) {
-  registers.at(instruction.x()) &= registers.at(instruction.y());
+  registers[instruction.x()] &= registers[instruction.y()];
+  if constexpr (Quirks::vf_reset) registers[Registers::VF] = 0;
 };
 
 /* 8xy3 - XOR Vx, Vy
@@ -158,8 +312,10 @@ void Cpu::AND_VX_VY(const Instruction &instruction) {
  * Performs a bitwise exclusive OR on the values of Vx and Vy, then stores the
  * result in Vx.
  */
+template <typename Quirks>
 void Cpu::XOR_VX_VY(const Instruction &instruction) {
-  registers.at(instruction.x()) ^= registers.at(instruction.y());
+  registers[instruction.x()] ^= registers[instruction.y()];
+  if constexpr (Quirks::vf_reset) registers[Registers::VF] = 0;
 };
 
 /* 8xy4 - ADD Vx, Vy
@@ -170,9 +326,9 @@ void Cpu::XOR_VX_VY(const Instruction &instruction) {
  * of the result are kept, and stored in Vx.
  */
 void Cpu::ADD_VX_VY(const Instruction &instruction) {
-  uint16_t sum = registers.at(instruction.x()) + registers.at(instruction.y());
-  registers.at(instruction.x()) = sum & 0xFF;
-  registers.at(Registers::VF) = (sum > 0xFF) ? 1 : 0;
+  uint16_t sum = registers[instruction.x()] + registers[instruction.y()];
+  registers[instruction.x()] = sum & 0xFF;
+  registers[Registers::VF] = (sum > 0xFF) ? 1 : 0;
 };
 
 /* 8xy5 - SUB Vx, Vy
@@ -182,20 +338,24 @@ void Cpu::ADD_VX_VY(const Instruction &instruction) {
  * Vx, and the results stored in Vx.
  */
 void Cpu::SUB_VX_VY(const Instruction &instruction) {
-  registers.at(Registers::VF) =
-      (registers.at(instruction.x()) >= registers.at(instruction.y())) ? 1 : 0;
-  registers.at(instruction.x()) -= registers.at(instruction.y());
+  registers[Registers::VF] =
+      (registers[instruction.x()] >= registers[instruction.y()]) ? 1 : 0;
+  registers[instruction.x()] -= registers[instruction.y()];
 };
 
 /* 8xy6 - SHR Vx {, Vy}
  * Set Vx = Vx SHR 1.
  *
  * If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0.
- * Then Vx is divided by 2.
+ * Then Vx is divided by 2. The COSMAC VIP first copies Vy into Vx.
  */
+template <typename Quirks>
 void Cpu::SHR_VX(const Instruction &instruction) {
-  registers.at(Registers::VF) = registers.at(instruction.x()) & 0x01;
-  registers.at(instruction.x()) >>= 1;
+  if constexpr (Quirks::shift_vy) {
+    registers[instruction.x()] = registers[instruction.y()];
+  }
+  registers[Registers::VF] = registers[instruction.x()] & 0x01;
+  registers[instruction.x()] >>= 1;
 };
 
 /* 8xy7 - SUBN Vx, Vy
@@ -205,20 +365,24 @@ void Cpu::SHR_VX(const Instruction &instruction) {
  * Vy, and the results stored in Vx.
  */
 void Cpu::SUBN_VX_VY(const Instruction &instruction) {
-  registers.at(Registers::VF) =
-      (registers.at(instruction.y()) >= registers.at(instruction.x())) ? 1 : 0;
-  registers.at(instruction.x()) -= registers.at(instruction.y());
+  registers[Registers::VF] =
+      (registers[instruction.y()] >= registers[instruction.x()]) ? 1 : 0;
+  registers[instruction.x()] -= registers[instruction.y()];
 };
 
 /* 8xyE - SHL Vx {, Vy}
  * Set Vx = Vx SHL 1.
  *
  * If the most-significant bit of Vx is 1, then VF is set to 1, otherwise to 0.
- * Then Vx is multiplied by 2.
+ * Then Vx is multiplied by 2. The COSMAC VIP first copies Vy into Vx.
  */
+template <typename Quirks>
 void Cpu::SHL_VX(const Instruction &instruction) {
-  registers.at(Registers::VF) = registers.at(instruction.x()) >> 7;
-  registers.at(instruction.x()) <<= 1;
+  if constexpr (Quirks::shift_vy) {
+    registers[instruction.x()] = registers[instruction.y()];
+  }
+  registers[Registers::VF] = registers[instruction.x()] >> 7;
+  registers[instruction.x()] <<= 1;
 };
 
 /* 9xy0 - SNE Vx, Vy
@@ -227,9 +391,9 @@ void Cpu::SHL_VX(const Instruction &instruction) {
  * The values of Vx and Vy are compared, and if they are not equal, the program
  * counter is increased by 2.
  */
-void Cpu::SNE_VX_VY(const Instruction &instruction) {
-  if (registers.at(instruction.x()) != registers.at(instruction.y())) {
-    pc += 2;
+void Cpu::SNE_VX_VY(const Instruction &instruction, const Memory &memory) {
+  if (registers[instruction.x()] != registers[instruction.y()]) {
+    Skip(memory);
   }
 };
 
@@ -243,10 +407,15 @@ void Cpu::LD_I(const Instruction &instruction) { I = instruction.addr(); };
 /* Bnnn - JP V0, addr
  * Jump to location nnn + V0.
  *
- * The program counter is set to nnn plus the value of V0.
+ * The program counter is set to nnn plus the value of V0. SUPER-CHIP adds
+ * Vx instead, taking x from the top nibble of nnn.
  */
+template <typename Quirks>
 void Cpu::JP_V0(const Instruction &instruction) {
-  pc = instruction.addr() + registers.at(Registers::V0);
+  const uint8_t offset = Quirks::jump_vx
+                             ? instruction.x()
+                             : static_cast<uint8_t>(Registers::V0);
+  pc = instruction.addr() + registers[offset];
 };
 
 /* Cxkk - RND Vx, byte
@@ -256,7 +425,7 @@ void Cpu::JP_V0(const Instruction &instruction) {
  * with the value kk. The results are stored in Vx.
  */
 void Cpu::RND_VX_KK(const Instruction &instruction) {
-  registers.at(instruction.x()) = RandomByte() & instruction.kk();
+  registers[instruction.x()] = RandomByte() & instruction.kk();
 };
 
 /* Dxyn - DRW Vx, Vy, nibble
@@ -268,22 +437,53 @@ void Cpu::RND_VX_KK(const Instruction &instruction) {
  * (Vx, Vy). Sprites are XORed onto the existing screen. If this causes any
  * pixels to be erased, VF is set to 1, otherwise it is set to 0. If the sprite
  * is positioned so part of it is outside the coordinates of the display, it
- * wraps around to the opposite side of the screen.
+ * wraps around to the opposite side of the screen. With the clip quirk only
+ * its starting position wraps and the part past the edge is not drawn.
+ *
+ * Dxy0 - DRW Vx, Vy, 0
+ * Draw a 16x16 sprite, two bytes a row, as SUPER-CHIP does.
+ *
+ * Each sprite row is XORed onto its packed display row at once. With XO-CHIP
+ * planes selected, the sprite is drawn on each of them in turn and the data
+ * for the next plane follows that of the previous one.
  */
+template <typename Quirks>
 void Cpu::DRW_VX_VY(const Instruction &instruction, Memory &memory) {
-  registers.at(Registers::VF) = 0;
-  for (auto y = 0; y < instruction.n(); ++y) {
-    uint8_t byte = memory.ram.at(I + y);
-    for (auto x = 0; x < 8; ++x) {
-      if (byte & (0x80 >> x)) {
-        uint16_t px = (registers.at(instruction.x()) + x) % DISPLAY_WIDTH;
-        uint16_t py = (registers.at(instruction.y()) + y) % DISPLAY_HEIGHT;
-        uint16_t xy = (px + (py * DISPLAY_WIDTH)) % DISPLAY_SIZE;
-        registers.at(Registers::VF) = memory.vram.at(xy);
-        memory.vram.at(xy) ^= 1;
+  const bool wide = instruction.n() == 0;
+  const auto height = wide ? 16 : instruction.n();
+  const auto size = wide ? 2 * height : height;
+  auto &vram = memory.vram;
+  auto planes = 0;
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    planes += vram.Selected(plane) ? 1 : 0;
+  }
+  if (!MemoryPolicy::InRam<Quirks::ram_size>(I, planes * size)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), I);
+  }
+  const auto left = registers[instruction.x()] % vram.Width();
+  const auto top = registers[instruction.y()] % vram.Height();
+  bool erased = false;
+  uint16_t sprite = I;
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    if (!vram.Selected(plane)) continue;
+    for (auto y = 0; y < height; ++y) {
+      auto row = top + y;
+      if (row >= vram.Height()) {
+        if (Quirks::clip) break;
+        row -= vram.Height();
       }
+      const auto at = wide ? sprite + (2 * y) : sprite + y;
+      uint64_t bits = memory.ram[MemoryPolicy::Ram<Quirks::ram_size>(at)];
+      if (wide) {
+        bits = (bits << 8) |
+               memory.ram[MemoryPolicy::Ram<Quirks::ram_size>(at + 1)];
+      }
+      bits <<= ROW_WORD_BITS - (wide ? 16 : 8);
+      erased |= vram.XorRow(plane, row, left, bits, Quirks::clip);
     }
+    sprite += size;
   }
+  registers[Registers::VF] = erased ? 1 : 0;
 };
 
 /* Ex9E - SKP Vx
@@ -292,9 +492,10 @@ void Cpu::DRW_VX_VY(const Instruction &instruction, Memory &memory) {
  * Checks the keyboard, and if the key corresponding to the value of Vx is
  * currently in the down position, PC is increased by 2.
  */
-void Cpu::SKP_VX(const Instruction &instruction, Input &input) {
-  if (input.IsDown(registers.at(instruction.x()))) {
-    pc += 2;
+void Cpu::SKP_VX(const Instruction &instruction, const Memory &memory,
+                  Input &input) {
+  if (input.IsDown(registers[instruction.x()])) {
+    Skip(memory);
   }
 };
 
@@ -304,10 +505,35 @@ void Cpu::SKP_VX(const Instruction &instruction, Input &input) {
  * Checks the keyboard, and if the key corresponding to the value of Vx is
  * currently in the up position, PC is increased by 2.
  */
-void Cpu::SKNP_VX(const Instruction &instruction, Input &input) {
-  if (!input.IsDown(registers.at(instruction.x()))) {
-    pc += 2;
+void Cpu::SKNP_VX(const Instruction &instruction, const Memory &memory,
+                   Input &input) {
+  if (!input.IsDown(registers[instruction.x()])) {
+    Skip(memory);
+  }
+};
+
+/* F000 nnnn - LD I, long nnnn
+ * Set I = nnnn, the 16-bit word following the instruction. From XO-CHIP.
+ *
+ * The instruction is four bytes long, so pc moves past the word as well.
+ */
+void Cpu::LD_I_LONG(const Memory &memory) {
+  if (!MemoryPolicy::InRam(pc, 2)) {
+    return RaiseFault(FaultKind::Fetch, 0xF000, pc);
   }
+  I = (memory.ram[MemoryPolicy::Ram(pc)] << 8) |
+      memory.ram[MemoryPolicy::Ram(pc + 1)];
+  pc += 2;
+};
+
+/* Fn01 - PLANE n
+ * Select the bit planes that drawing, clearing and scrolling apply to. From
+ * XO-CHIP.
+ *
+ * n is a mask, one bit per plane.
+ */
+void Cpu::PLANE(const Instruction &instruction, Memory &memory) {
+  memory.vram.selected = instruction.x() & (NUM_COLORS - 1);
 };
 
 /* Fx07 - LD Vx, DT
@@ -316,7 +542,7 @@ void Cpu::SKNP_VX(const Instruction &instruction, Input &input) {
  * The value of DT is placed into Vx.
  */
 void Cpu::LD_VX_DT(const Instruction &instruction) {
-  registers.at(instruction.x()) = t_delay;
+  registers[instruction.x()] = t_delay;
 };
 
 /* Fx0A - LD Vx, K
@@ -324,13 +550,15 @@ void Cpu::LD_VX_DT(const Instruction &instruction) {
  *
  * All execution stops until a key is pressed, then the value of that key is
  * stored in Vx.
+ *
+ * As on the COSMAC VIP, the key counts once it is released. The CPU halts
+ * with pc left on this instruction, and the Machine completes it when the
+ * keypad reports the release.
  */
-void Cpu::LD_VX_K(const Instruction &instruction, Input &input) {
-  for (auto i = 0; i < 0x0F; ++i) {
-    if (input.IsDown(i)) {
-      registers.at(instruction.x()) = i;
-    }
-  }
+void Cpu::LD_VX_K(Input &input) {
+  pc -= 2;
+  halted = true;
+  input.WaitForKey();
 };
 
 /* Fx15 - LD DT, Vx
@@ -339,7 +567,7 @@ void Cpu::LD_VX_K(const Instruction &instruction, Input &input) {
  * DT is set equal to the value of Vx.
  */
 void Cpu::LD_DT_VX(const Instruction &instruction) {
-  t_delay = registers.at(instruction.x());
+  t_delay = registers[instruction.x()];
 };
 
 /* Fx18 - LD ST, Vx
@@ -348,7 +576,7 @@ void Cpu::LD_DT_VX(const Instruction &instruction) {
  * ST is set equal to the value of Vx.
  */
 void Cpu::LD_ST_VX(const Instruction &instruction) {
-  t_sound = registers.at(instruction.x());
+  t_sound = registers[instruction.x()];
 };
 
 /* Fx1E - ADD I, Vx
@@ -357,7 +585,7 @@ void Cpu::LD_ST_VX(const Instruction &instruction) {
  * The values of I and Vx are added, and the results are stored in I.
  */
 void Cpu::ADD_I_VX(const Instruction &instruction) {
-  I += registers.at(instruction.x());
+  I += registers[instruction.x()];
 };
 
 /* Fx29 - LD F, Vx
@@ -367,7 +595,14 @@ void Cpu::ADD_I_VX(const Instruction &instruction) {
  * corresponding to the value of Vx.
  */
 void Cpu::LD_F_VX(const Instruction &instruction) {
-  I = SPRITES_LOCATION + (registers.at(instruction.x()) * SPRITE_SIZE);
+  I = SPRITES_LOCATION + (registers[instruction.x()] * SPRITE_SIZE);
+};
+
+/* Fx30 - LD HF, Vx
+ * Set I = location of 10-byte font sprite for digit Vx.
+ */
+void Cpu::LD_HF_VX(const Instruction &instruction) {
+  I = BIG_SPRITES_LOCATION + (registers[instruction.x()] * BIG_SPRITE_SIZE);
 };
 
 /* Fx33 - LD B, Vx
@@ -377,38 +612,100 @@ void Cpu::LD_F_VX(const Instruction &instruction) {
  * in memory at location in I, the tens digit at location I+1, and the ones
  * digit at location I+2.
  */
+template <typename Quirks>
 void Cpu::LD_B_VX(const Instruction &instruction, Memory &memory) {
-  memory.ram.at(I) = registers.at(instruction.x()) / 100;
-  memory.ram.at(I + 1) = (registers.at(instruction.x()) / 10) % 10;
-  memory.ram.at(I + 2) = registers.at(instruction.x()) % 10;
+  if (!MemoryPolicy::InRam<Quirks::ram_size>(I, 3)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), I);
+  }
+  const auto value = registers[instruction.x()];
+  memory.Write(MemoryPolicy::Ram<Quirks::ram_size>(I), value / 100);
+  memory.Write(MemoryPolicy::Ram<Quirks::ram_size>(I + 1), (value / 10) % 10);
+  memory.Write(MemoryPolicy::Ram<Quirks::ram_size>(I + 2), value % 10);
 };
 
 /* Fx55 - LD [I], Vx
  * Store registers V0 through Vx in memory starting at location I.
  *
  * The interpreter copies the values of registers V0 through Vx into memory,
- * starting at the address in I.
+ * starting at the address in I. The COSMAC VIP leaves I at I + x + 1.
  */
+template <typename Quirks>
 void Cpu::LD_I_VX(const Instruction &instruction, Memory &memory) {
   auto addr = I;
+  if (!MemoryPolicy::InRam<Quirks::ram_size>(addr, instruction.x() + 1)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), addr);
+  }
   for (auto i = 0; i <= instruction.x(); ++i) {
-    memory.ram.at(addr + i) = registers.at(i);
+    memory.Write(MemoryPolicy::Ram<Quirks::ram_size>(addr + i), registers[i]);
   }
+  if constexpr (Quirks::increment_i) I += instruction.x() + 1;
 };
 
 /* Fx65 - LD Vx, [I]
  * Read registers V0 through Vx from memory starting at location I.
  *
  * The interpreter reads values from memory starting at location I into
- * registers V0 through Vx.
+ * registers V0 through Vx. The COSMAC VIP leaves I at I + x + 1.
  */
+template <typename Quirks>
 void Cpu::LD_VX_I(const Instruction &instruction, Memory &memory) {
   auto addr = I;
+  if (!MemoryPolicy::InRam<Quirks::ram_size>(addr, instruction.x() + 1)) {
+    return RaiseFault(FaultKind::Ram, instruction.instruction(), addr);
+  }
   for (auto i = 0; i <= instruction.x(); ++i) {
-    registers.at(i) = memory.ram.at(addr + i);
+    registers[i] = memory.ram[MemoryPolicy::Ram<Quirks::ram_size>(addr + i)];
   }
+  if constexpr (Quirks::increment_i) I += instruction.x() + 1;
+};
+
+/* Fx75 - LD R, Vx
+ * Store V0..Vx in RPL user flags.
+ */
+void Cpu::LD_R_VX(const Instruction &instruction, Memory &memory) {
+  for (auto i = 0; i <= instruction.x(); ++i) memory.rpl[i] = registers[i];
 };
 
+/* Fx85 - LD Vx, R
+ * Read V0..Vx from RPL user flags.
+ */
+void Cpu::LD_VX_R(const Instruction &instruction, Memory &memory) {
+  for (auto i = 0; i <= instruction.x(); ++i) registers[i] = memory.rpl[i];
+};
+
+template void Cpu::OR_VX_VY<Chip8Quirks>(const Instruction &);
+template void Cpu::AND_VX_VY<Chip8Quirks>(const Instruction &);
+template void Cpu::XOR_VX_VY<Chip8Quirks>(const Instruction &);
+template void Cpu::SHR_VX<Chip8Quirks>(const Instruction &);
+template void Cpu::SHL_VX<Chip8Quirks>(const Instruction &);
+template void Cpu::JP_V0<Chip8Quirks>(const Instruction &);
+template void Cpu::DRW_VX_VY<Chip8Quirks>(const Instruction &, Memory &);
+template void Cpu::LD_B_VX<Chip8Quirks>(const Instruction &, Memory &);
+template void Cpu::LD_I_VX<Chip8Quirks>(const Instruction &, Memory &);
+template void Cpu::LD_VX_I<Chip8Quirks>(const Instruction &, Memory &);
+
+template void Cpu::OR_VX_VY<SuperChipQuirks>(const Instruction &);
+template void Cpu::AND_VX_VY<SuperChipQuirks>(const Instruction &);
+template void Cpu::XOR_VX_VY<SuperChipQuirks>(const Instruction &);
+template void Cpu::SHR_VX<SuperChipQuirks>(const Instruction &);
+template void Cpu::SHL_VX<SuperChipQuirks>(const Instruction &);
+template void Cpu::JP_V0<SuperChipQuirks>(const Instruction &);
+template void Cpu::DRW_VX_VY<SuperChipQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_B_VX<SuperChipQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_I_VX<SuperChipQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_VX_I<SuperChipQuirks>(const Instruction &, Memory &);
+
+template void Cpu::OR_VX_VY<ModernQuirks>(const Instruction &);
+template void Cpu::AND_VX_VY<ModernQuirks>(const Instruction &);
+template void Cpu::XOR_VX_VY<ModernQuirks>(const Instruction &);
+template void Cpu::SHR_VX<ModernQuirks>(const Instruction &);
+template void Cpu::SHL_VX<ModernQuirks>(const Instruction &);
+template void Cpu::JP_V0<ModernQuirks>(const Instruction &);
+template void Cpu::DRW_VX_VY<ModernQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_B_VX<ModernQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_I_VX<ModernQuirks>(const Instruction &, Memory &);
+template void Cpu::LD_VX_I<ModernQuirks>(const Instruction &, Memory &);
+
 void Cpu::UNKNOWN(const Instruction &instruction) {
   std::cerr << "Unknown instruction " << std::hex << std::setw(4)
             << instruction.instruction() << std::endl;
@@ -0,0 +1,169 @@
+#include <cchip8/dispatch.h>
+#include <cchip8/handlers.h>
+#include <cchip8/instruction.h>
+#include <cchip8/quirks.h>
+
+#include <array>
+#include <cstdint>
+
+namespace cchip8 {
+
+namespace {
+
+/* Indexed by Opcode */
+template <typename Quirks>
+constexpr std::array<Handler, NUM_OPCODES> HANDLER_BY_OPCODE = {
+    ExecCLS,
+    ExecRET,
+    ExecSCD,
+    ExecSCU,
+    ExecSCR,
+    ExecSCL,
+    ExecEXIT,
+    ExecLOW,
+    ExecHIGH,
+    ExecSYS,
+    ExecJP,
+    ExecCALL,
+    ExecSE_VX_KK,
+    ExecSNE_VX_KK,
+    ExecSE_VX_VY,
+    ExecLD_I_VX_VY,
+    ExecLD_VX_VY_I,
+    ExecLD_VX_KK,
+    ExecADD_VX_KK,
+    ExecLD_VX_VY,
+    ExecOR_VX_VY<Quirks>,
+    ExecAND_VX_VY<Quirks>,
+    ExecXOR_VX_VY<Quirks>,
+    ExecADD_VX_VY,
+    ExecSUB_VX_VY,
+    ExecSHR_VX<Quirks>,
+    ExecSUBN_VX_VY,
+    ExecSHL_VX<Quirks>,
+    ExecSNE_VX_VY,
+    ExecLD_I,
+    ExecJP_V0<Quirks>,
+    ExecRND_VX_KK,
+    ExecDRW_VX_VY<Quirks>,
+    ExecSKP_VX,
+    ExecSKNP_VX,
+    ExecLD_I_LONG,
+    ExecPLANE,
+    ExecLD_VX_DT,
+    ExecLD_VX_K,
+    ExecLD_DT_VX,
+    ExecLD_ST_VX,
+    ExecADD_I_VX,
+    ExecLD_F_VX,
+    ExecLD_HF_VX,
+    ExecLD_B_VX<Quirks>,
+    ExecLD_I_VX<Quirks>,
+    ExecLD_VX_I<Quirks>,
+    ExecLD_R_VX,
+    ExecLD_VX_R,
+    ExecUNKNOWN,
+};
+
+/*
+ * The instruction set written out as (mask, match) patterns, independently
+ * of the nested switch in Instruction::Decode(). The first pattern whose
+ * masked bits match a word decides its opcode, so the more specific 00E0,
+ * 00EE and the SUPER-CHIP and XO-CHIP 00xx instructions come before the
+ * catch-all 0nnn, and 5xy2 and 5xy3 before 5xyn.
+ */
+struct Pattern {
+  uint16_t mask;
+  uint16_t match;
+  Opcode opcode;
+};
+
+constexpr std::array<Pattern, NUM_OPCODES - 1> PATTERNS = {{
+    {0xFFFF, 0x00E0, Opcode::CLS},        {0xFFFF, 0x00EE, Opcode::RET},
+    {0xFFF0, 0x00C0, Opcode::SCD},        {0xFFF0, 0x00D0, Opcode::SCU},
+    {0xFFFF, 0x00FB, Opcode::SCR},        {0xFFFF, 0x00FC, Opcode::SCL},
+    {0xFFFF, 0x00FD, Opcode::EXIT},       {0xFFFF, 0x00FE, Opcode::LOW},
+    {0xFFFF, 0x00FF, Opcode::HIGH},       {0xF000, 0x0000, Opcode::SYS},
+    {0xF000, 0x1000, Opcode::JP},         {0xF000, 0x2000, Opcode::CALL},
+    {0xF000, 0x3000, Opcode::SE_VX_KK},   {0xF000, 0x4000, Opcode::SNE_VX_KK},
+    {0xF00F, 0x5002, Opcode::LD_I_VX_VY}, {0xF00F, 0x5003, Opcode::LD_VX_VY_I},
+    {0xF000, 0x5000, Opcode::SE_VX_VY},   {0xF000, 0x6000, Opcode::LD_VX_KK},
+    {0xF000, 0x7000, Opcode::ADD_VX_KK},  {0xF00F, 0x8000, Opcode::LD_VX_VY},
+    {0xF00F, 0x8001, Opcode::OR_VX_VY},   {0xF00F, 0x8002, Opcode::AND_VX_VY},
+    {0xF00F, 0x8003, Opcode::XOR_VX_VY},  {0xF00F, 0x8004, Opcode::ADD_VX_VY},
+    {0xF00F, 0x8005, Opcode::SUB_VX_VY},  {0xF00F, 0x8006, Opcode::SHR_VX},
+    {0xF00F, 0x8007, Opcode::SUBN_VX_VY}, {0xF00F, 0x800E, Opcode::SHL_VX},
+    {0xF000, 0x9000, Opcode::SNE_VX_VY},  {0xF000, 0xA000, Opcode::LD_I},
+    {0xF000, 0xB000, Opcode::JP_V0},      {0xF000, 0xC000, Opcode::RND_VX_KK},
+    {0xF000, 0xD000, Opcode::DRW_VX_VY},  {0xF0FF, 0xE09E, Opcode::SKP_VX},
+    {0xF0FF, 0xE0A1, Opcode::SKNP_VX},    {0xFFFF, 0xF000, Opcode::LD_I_LONG},
+    {0xF0FF, 0xF001, Opcode::PLANE},      {0xF0FF, 0xF007, Opcode::LD_VX_DT},
+    {0xF0FF, 0xF00A, Opcode::LD_VX_K},    {0xF0FF, 0xF015, Opcode::LD_DT_VX},
+    {0xF0FF, 0xF018, Opcode::LD_ST_VX},   {0xF0FF, 0xF01E, Opcode::ADD_I_VX},
+    {0xF0FF, 0xF029, Opcode::LD_F_VX},    {0xF0FF, 0xF030, Opcode::LD_HF_VX},
+    {0xF0FF, 0xF033, Opcode::LD_B_VX},    {0xF0FF, 0xF055, Opcode::LD_I_VX},
+    {0xF0FF, 0xF065, Opcode::LD_VX_I},    {0xF0FF, 0xF075, Opcode::LD_R_VX},
+    {0xF0FF, 0xF085, Opcode::LD_VX_R},
+}};
+
+/*
+ * Every pattern fixes the most significant nibble, so each one only needs to
+ * visit the 4096 words sharing it. Patterns are applied last to first so that
+ * earlier ones take precedence.
+ */
+constexpr std::array<Opcode, NUM_INSTRUCTION_WORDS> BuildOpcodeTable() {
+  std::array<Opcode, NUM_INSTRUCTION_WORDS> table{};
+  for (auto &opcode : table) opcode = Opcode::UNKNOWN;
+  for (auto p = PATTERNS.size(); p-- > 0;) {
+    const auto &pattern = PATTERNS[p];
+    const uint32_t base = pattern.match & 0xF000;
+    for (uint32_t word = base; word < base + 0x1000; ++word) {
+      if ((word & pattern.mask) == pattern.match) table[word] = pattern.opcode;
+    }
+  }
+  return table;
+}
+
+constexpr auto OPCODES = BuildOpcodeTable();
+
+constexpr bool AgreesWithDecode(const uint32_t begin, const uint32_t end) {
+  for (auto word = begin; word < end; ++word) {
+    if (OPCODES[word] != Instruction(static_cast<uint16_t>(word)).Decode()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Split in quarters to stay within the compilers' constexpr step limits */
+static_assert(AgreesWithDecode(0x0000, 0x4000),
+              "Handler table disagrees with Instruction::Decode()");
+static_assert(AgreesWithDecode(0x4000, 0x8000),
+              "Handler table disagrees with Instruction::Decode()");
+static_assert(AgreesWithDecode(0x8000, 0xC000),
+              "Handler table disagrees with Instruction::Decode()");
+static_assert(AgreesWithDecode(0xC000, 0x10000),
+              "Handler table disagrees with Instruction::Decode()");
+
+template <typename Quirks>
+constexpr std::array<Handler, NUM_INSTRUCTION_WORDS> BuildHandlerTable() {
+  std::array<Handler, NUM_INSTRUCTION_WORDS> table{};
+  for (uint32_t word = 0; word < NUM_INSTRUCTION_WORDS; ++word) {
+    table[word] =
+        HANDLER_BY_OPCODE<Quirks>[static_cast<size_t>(OPCODES[word])];
+  }
+  return table;
+}
+
+}  // namespace
+
+/* Constant-initialized, as BuildHandlerTable() is constexpr */
+template <typename Quirks>
+const std::array<Handler, NUM_INSTRUCTION_WORDS> Dispatch<Quirks>::HANDLERS =
+    BuildHandlerTable<Quirks>();
+
+template struct Dispatch<Chip8Quirks>;
+template struct Dispatch<SuperChipQuirks>;
+template struct Dispatch<ModernQuirks>;
+
+}  // namespace cchip8
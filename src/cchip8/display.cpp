@@ -1,27 +1,87 @@
 #include <SDL.h>
 #include <cchip8/display.h>
+#include <cchip8/framebuffer.h>
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <iostream>
 
 namespace cchip8 {
 
-void Display::Init(float pos_x, float pos_y, SDL_Renderer* renderer) {
-  m_pos_x = pos_x;
-  m_pos_y = pos_y;
+namespace {
+
+/* XRGB8888, indexed by the pixel's bit from each plane, plane 0 lowest */
+constexpr std::array<uint32_t, NUM_COLORS> PALETTE = {
+    0xFF000000,
+    0xFFFFFFFF,
+    0xFFAAAAAA,
+    0xFF555555,
+};
+
+constexpr int PITCH = HIRES_WIDTH * sizeof(uint32_t);
+
+}  // namespace
+
+bool Display::Init(SDL_Renderer* renderer) {
   m_renderer = renderer;
+  m_texture =
+      SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_XRGB8888,
+                        SDL_TEXTUREACCESS_STREAMING, HIRES_WIDTH, HIRES_HEIGHT);
+  if (m_texture == nullptr) {
+    SDL_Log("Unable to create the display texture: %s", SDL_GetError());
+    return false;
+  }
+  SDL_SetTextureScaleMode(m_texture, SDL_SCALEMODE_NEAREST);
+  m_pixels.assign(HIRES_WIDTH * HIRES_HEIGHT, PALETTE[0]);
+  return true;
 }
 
-void Display::DrawPixel(float x, float y) {
-  if (m_renderer == nullptr) {
-    std::cerr << "Renderer is not set!" << std::endl;
+void Display::Quit() {
+  if (m_texture != nullptr) SDL_DestroyTexture(m_texture);
+  m_texture = nullptr;
+}
+
+void Display::Update(const Framebuffer& vram, const uint64_t rows) {
+  if (m_texture == nullptr) {
+    std::cerr << "Display texture is not set!" << std::endl;
     return;
   }
-  SDL_SetRenderDrawColor(m_renderer, 0xFF, 0xFF, 0xFF, 0xFF);
-  const SDL_FRect block{(m_pos_x + x) * DISPLAY_SCALE,
-                        (m_pos_y + y) * DISPLAY_SCALE, DISPLAY_SCALE,
-                        DISPLAY_SCALE};
-  SDL_RenderRect(m_renderer, &block);
-  SDL_RenderFillRect(m_renderer, &block);
+  m_columns = vram.Width();
+  m_rows = vram.Height();
+  auto first = m_rows;
+  auto last = -1;
+  for (auto y = 0; y < m_rows; ++y) {
+    if (((rows >> y) & 1) == 0) continue;
+    first = std::min(first, y);
+    last = y;
+    auto* row = m_pixels.data() + (y * HIRES_WIDTH);
+    for (auto x = 0; x < m_columns;) {
+      uint8_t color = 0;
+      const auto run = vram.Span(x, y, color);
+      std::fill(row + x, row + x + run, PALETTE[color]);
+      x += run;
+    }
+  }
+  if (last < first) return;
+  /* One upload spanning the changed rows, which are usually close together */
+  const SDL_Rect changed{0, first, m_columns, last - first + 1};
+  SDL_UpdateTexture(m_texture, &changed,
+                    m_pixels.data() + (first * HIRES_WIDTH), PITCH);
+}
+
+void Display::Draw(const int width, const int height) {
+  if (m_texture == nullptr) return;
+  const auto scale =
+      std::max(1, std::min(width / m_columns, height / m_rows));
+  const SDL_FRect source{0, 0, static_cast<float>(m_columns),
+                         static_cast<float>(m_rows)};
+  const SDL_FRect target{
+      static_cast<float>((width - (m_columns * scale)) / 2),
+      static_cast<float>((height - (m_rows * scale)) / 2),
+      static_cast<float>(m_columns * scale),
+      static_cast<float>(m_rows * scale)};
+  SDL_RenderTexture(m_renderer, m_texture, &source, &target);
 }
 
 void Display::HandleEvent(const SDL_Event& event) {
@@ -1,19 +1,30 @@
 #include <SDL.h>
 #include <SDL3_ttf/SDL_ttf.h>
-#include <cchip8/cpu.h>
 #include <cchip8/emulator.h>
 #include <cchip8/events.h>
-#include <cchip8/input.h>
-#include <cchip8/memory.h>
+#include <cchip8/machine.h>
 #include <cchip8/rom.h>
 #include <cchip8/window.h>
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <random>
+#include <string>
 #include <thread>
 
 namespace cchip8 {
 
+namespace {
+
+/* The start of a slice of an emulated frame, in samples of emulated time */
+uint64_t SoundTime(const uint64_t frame, const int slice) {
+  return ((frame * SOUND_SLICES) + slice) * AUDIO_SAMPLE_RATE /
+         (FRAME_RATE * SOUND_SLICES);
+}
+
+}  // namespace
+
 bool Emulator::LoadRom(const Rom& rom) {
   if (m_running) {
     std::cerr << "Cannot load rom, emulator is already running one."
@@ -21,20 +32,42 @@ bool Emulator::LoadRom(const Rom& rom) {
     return false;
   }
   m_rom = rom;
-  m_rom_loaded = m_memory.LoadProgram(m_rom, PROGRAM_START);
-  m_cpu.pc = PROGRAM_START;
+  m_rom_hash = m_rom.Hash();
+  m_rom_loaded = m_machine.Load(m_rom);
+  Seed();
+  m_rewind.Clear();
   return m_rom_loaded;
 }
 
+void Emulator::Seed() {
+  m_machine.cpu.Seed(m_seed.value_or(std::random_device{}()));
+}
+
+void Emulator::SetTicksPerFrame(const int ticks) {
+  m_ticks_per_frame =
+      std::clamp(ticks, MIN_TICKS_PER_FRAME, MAX_TICKS_PER_FRAME);
+}
+
+void Emulator::SetTurbo(const bool enabled) {
+  m_turbo = enabled;
+  /* Back at 60 Hz, the time spent in turbo is not caught up on */
+  if (!m_turbo) m_scheduler.Start();
+}
+
+bool Emulator::Play(const std::string& filename) {
+  m_playing = m_movie.Load(filename);
+  return m_playing;
+}
+
 void Emulator::Reset() {
-  m_reset = true;
+  m_movie_frame = 0;
+  if (Recording()) m_movie.Clear();
   m_paused = false;
-  m_window.Clear();
-  m_cpu.Reset();
-  m_rom_loaded = m_memory.LoadProgram(m_rom, PROGRAM_START);
-  m_cpu.pc = PROGRAM_START;
-  m_input.Reset();
-  m_audio.Reset();
+  m_rom_loaded = m_machine.Load(m_rom);
+  Seed();
+  m_rewind.Clear();
+  SilenceTone();
+  Publish(true);
 }
 
 bool Emulator::InitDevices() {
@@ -60,51 +93,269 @@ void Emulator::Start() {
     std::cerr << "Cannot start emulator, no ROM has been loaded." << std::endl;
     return;
   }
+  if (m_playing) {
+    if (!m_movie.Prepare(m_rom, m_machine)) return;
+    m_seed = m_movie.seed;
+    SetTicksPerFrame(m_movie.ticks_per_frame);
+  } else if (Recording()) {
+    if (!m_seed) {
+      m_seed = std::random_device{}();
+      Seed();
+    }
+    m_movie.seed = *m_seed;
+    m_movie.rom_hash = m_rom_hash;
+    m_movie.quirks = m_machine.GetQuirks();
+    m_movie.ticks_per_frame = m_ticks_per_frame;
+  }
   if (InitDevices()) {
     m_running = true;
+    if (m_autosave_enabled) OpenAutosave();
     MainLoop();
   }
+  if (Recording()) {
+    if (m_movie.Save(m_record_file)) {
+      SDL_Log("Recorded %zu frames to %s", m_movie.Frames(),
+              m_record_file.c_str());
+    }
+  }
 }
 
-void Emulator::MainLoop() {
-  using namespace std::chrono;
-  auto lastDrawTime = high_resolution_clock::now();
+void Emulator::OpenAutosave() {
+  if (!m_autosave.Open(m_rom.Filename() + ".autosave")) return;
+  /* A movie has to start from the program's first frame */
+  if (MovieActive()) return;
+  if (m_autosave.Restore(m_rom_hash, m_machine)) {
+    SDL_Log("Resumed from the autosave");
+    Publish(true);
+    m_machine.draw = false;
+  }
+}
 
-  while (m_running && m_window.running) {
-    auto currentTime = high_resolution_clock::now();
-    auto elapsedTime = duration_cast<milliseconds>(currentTime - lastDrawTime);
+std::string Emulator::SlotFilename(const int slot) const {
+  return m_rom.Filename() + ".state" + std::to_string(slot);
+}
 
-    if (elapsedTime.count() > (1000.0 / 60.0)) {
-      lastDrawTime = currentTime;
-      Update();
-    }
-    if (m_reset) m_reset = false;
-    std::this_thread::sleep_for(milliseconds(16));
+void Emulator::SaveSlot(const int slot) {
+  if (SaveStateToFile(SlotFilename(slot), m_machine, m_rom_hash)) {
+    SDL_Log("Saved state %d", slot);
+  }
+}
+
+/* Only the machine is replaced. The ROM is not read again and the devices
+ * are left as they are.
+ */
+void Emulator::LoadSlot(const int slot) {
+  if (LoadStateFromFile(SlotFilename(slot), m_rom_hash, m_machine)) {
+    SDL_Log("Loaded state %d", slot);
+    Publish(true);
+    m_machine.draw = false;
   }
 }
 
-void Emulator::UpdateTimers() {
-  if (m_cpu.t_delay > 0) {
-    --m_cpu.t_delay;
+bool Emulator::LockedByMovie() const {
+  if (MovieActive()) SDL_Log("Not available while a movie is active");
+  return MovieActive();
+}
+
+/*
+ * During a movie the keypad is set once per frame, from the movie when
+ * playing it, or from the keyboard when recording, in which case the keys
+ * are recorded. Returns false once the movie has been played through.
+ */
+bool Emulator::FeedKeys() {
+  if (m_playing) {
+    if (m_movie_frame >= m_movie.Frames()) return false;
+    m_machine.input.SetKeys(m_movie.Keys(m_movie_frame++));
+  } else if (Recording()) {
+    const auto keys = m_keypad.TakeFrameKeys();
+    m_machine.input.SetKeys(keys);
+    m_movie.Record(keys);
   }
-  if (m_cpu.t_sound > 0) {
-    --m_cpu.t_sound;
+  return true;
+}
+
+void Emulator::MainLoop() {
+  std::thread emulation(&Emulator::EmulationLoop, this);
+  while (m_running && m_window.running) {
+    PollEvents();
+    if (!Present()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
+  m_running = false;
+  emulation.join();
+
+  const auto& stats = m_machine.stats;
+  if (stats.ticks > 0) {
+    SDL_Log("Skipped %llu of %llu ticks in idle loops (%.1f%%)",
+            static_cast<unsigned long long>(stats.skipped),
+            static_cast<unsigned long long>(stats.ticks),
+            100.0 * stats.skipped / stats.ticks);
+    SDL_Log("Halted waiting for a key for %llu ticks (%.1f%%)",
+            static_cast<unsigned long long>(stats.halted),
+            100.0 * stats.halted / stats.ticks);
+  }
+  const auto& rewind = m_rewind.Stats();
+  if (rewind.captures > 0) {
+    using std::chrono::duration;
+    SDL_Log("Rewind holds %zu frames in %.2f MB, captured in %.1f us on "
+            "average and %.1f us at most",
+            m_rewind.Frames(), m_rewind.BytesUsed() / (1024.0 * 1024.0),
+            duration<double, std::micro>(rewind.capture_time).count() /
+                rewind.captures,
+            duration<double, std::micro>(rewind.capture_max).count());
+  }
+  SDL_Log("Published %llu frames and skipped %llu unchanged ones",
+          static_cast<unsigned long long>(m_frames_published),
+          static_cast<unsigned long long>(m_frames_unchanged));
+  SDL_Log("Presented %llu frames, %llu were replaced before they could be",
+          static_cast<unsigned long long>(m_frames_presented),
+          static_cast<unsigned long long>(m_frames_superseded));
+  const auto audio = m_audio.Stats();
+  if (audio.callbacks > 0) {
+    using std::chrono::duration;
+    SDL_Log("Audio ran %llu callbacks in %.1f us on average and %.1f us at "
+            "most, %llu edges arrived late",
+            static_cast<unsigned long long>(audio.callbacks),
+            duration<double, std::micro>(audio.callback_time).count() /
+                audio.callbacks,
+            duration<double, std::micro>(audio.callback_max).count(),
+            static_cast<unsigned long long>(audio.underruns));
+    SDL_Log("Audio queued %.1f ms on average and %.1f ms at most",
+            1000.0 * audio.queued_total / audio.callbacks / AUDIO_SAMPLE_RATE,
+            1000.0 * audio.queued_max / AUDIO_SAMPLE_RATE);
+  }
+  if (m_latency.Count() > 0) {
+    SDL_Log("Key to photon latency p50 %.1f ms, p99 %.1f ms, %.1f ms at most "
+            "over %llu presses",
+            m_latency.Percentile(50), m_latency.Percentile(99),
+            m_latency.Max(),
+            static_cast<unsigned long long>(m_latency.Count()));
+  }
+  SDL_Log("Frame period p50 %.2f ms, p99 %.2f ms, %llu frames dropped",
+          m_scheduler.Percentile(50), m_scheduler.Percentile(99),
+          static_cast<unsigned long long>(m_scheduler.Dropped()));
 }
 
-void Emulator::UpdateSound() {
-  if (m_cpu.t_sound > 0) {
-    m_audio.StartTone();
-  } else {
-    m_audio.PauseTone();
+/* Runs frames at their deadlines until either thread stops. While paused,
+ * waits for the event that resumes it, and starts the deadlines again from
+ * then so the pause is neither caught up on nor counted as a frame period.
+ */
+void Emulator::EmulationLoop() {
+  m_key_events.reserve(EVENT_QUEUE_SIZE);
+  m_scheduler.Start();
+  m_report_time = FrameScheduler::Clock::now();
+  while (m_running) {
+    const auto frames = m_turbo ? TURBO_DRAW_INTERVAL : m_scheduler.Wait();
+    ReceiveEvents();
+    if (m_paused) {
+      m_audio.SetMuted(true);
+      while (m_paused && m_running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ReceiveEvents();
+      }
+      m_audio.SetMuted(false);
+      m_scheduler.Start();
+      m_pressed = 0;
+      continue;
+    }
+    Update(frames);
+    /* A press the frames just run did not visibly answer is not measured */
+    m_pressed = 0;
+    ReportThroughput(false);
+  }
+  ReportThroughput(true);
+  m_audio.SetMuted(true);
+}
+
+/* Logs the instructions and frames emulated per second of host time, about
+ * once every THROUGHPUT_REPORT_INTERVAL_MS
+ */
+void Emulator::ReportThroughput(const bool force) {
+  using namespace std::chrono;
+  const auto now = FrameScheduler::Clock::now();
+  const auto elapsed = duration<double>(now - m_report_time).count();
+  if (!force && elapsed * 1000 < THROUGHPUT_REPORT_INTERVAL_MS) return;
+  if (elapsed <= 0) return;
+  const auto ticks = m_machine.stats.ticks - m_report_ticks;
+  const auto frames = m_frames - m_report_frames;
+  SDL_Log("%.0f IPS, %.1f emulated FPS at %d instructions per frame%s",
+          ticks / elapsed, frames / elapsed, m_ticks_per_frame,
+          m_turbo ? " (turbo)" : "");
+  m_report_time = now;
+  m_report_ticks = m_machine.stats.ticks;
+  m_report_frames = m_frames;
+}
+
+/* Queues the tone's edges in the frame just run, at the slices where the
+ * sound timer started or stopped
+ */
+void Emulator::QueueSound() {
+  for (auto slice = 0; slice < SOUND_SLICES; ++slice) {
+    const bool on = ((m_machine.sound >> slice) & 1) != 0;
+    if (on == m_tone) continue;
+    m_tone = on;
+    m_audio.QueueEdge(SoundTime(m_frames, slice), on);
   }
 }
 
+void Emulator::SilenceTone() {
+  if (!m_tone) return;
+  m_tone = false;
+  m_audio.QueueEdge(SoundTime(m_frames, 0), false);
+}
+
+/* Keys go to the emulation thread as they are. Escape and the window's
+ * own events are dealt with here.
+ */
 void Emulator::PollEvents() {
   while (SDL_PollEvent(&m_event) != 0) {
-    m_input.HandleEvent(m_event);
     m_window.HandleEvent(m_event);
-    HandleEvent(m_event);
+    switch (m_event.type) {
+      case SDL_EVENT_KEY_DOWN:
+        if (m_event.key.keysym.sym == SDLK_ESCAPE) {
+          Pause();
+          break;
+        }
+        Send(m_event);
+        break;
+      case SDL_EVENT_KEY_UP:
+        Send(m_event);
+        break;
+      case SDL_PAUSE_GAME:
+        Pause();
+        break;
+      case SDL_EVENT_QUIT:
+        m_running = false;
+        break;
+    }
+  }
+}
+
+void Emulator::Send(const SDL_Event& event) {
+  if (!m_events.Push(event)) SDL_Log("Event queue full, dropped an event");
+}
+
+void Emulator::Send(const Uint32 type) {
+  SDL_Event event{};
+  event.type = type;
+  Send(event);
+}
+
+void Emulator::ReceiveEvents() {
+  SDL_Event event{};
+  while (m_events.Pop(event)) {
+    if (event.type == SDL_EVENT_KEY_DOWN || event.type == SDL_EVENT_KEY_UP) {
+      if (MovieActive()) {
+        m_keypad.HandleEvent(event);
+      } else {
+        m_key_events.push_back(event);
+      }
+      if (event.type == SDL_EVENT_KEY_DOWN && event.key.repeat == 0 &&
+          m_pressed == 0 &&
+          m_machine.input.KeyOf(event.key.keysym.sym) != NUM_KEYS) {
+        m_pressed = event.key.timestamp;
+      }
+    }
+    HandleEvent(event);
   }
 }
 
@@ -112,30 +363,65 @@ void Emulator::HandleEvent(const SDL_Event& event) {
   switch (event.type) {
     case SDL_EVENT_KEY_DOWN:
       switch (event.key.keysym.sym) {
-        case SDLK_ESCAPE:
-          Pause();
+        case SDLK_EQUALS:
+          if (LockedByMovie()) break;
+          SetTicksPerFrame(m_ticks_per_frame * 2);
+          SDL_Log("%d instructions per frame", m_ticks_per_frame);
+          break;
+        case SDLK_MINUS:
+          if (LockedByMovie()) break;
+          SetTicksPerFrame(m_ticks_per_frame / 2);
+          SDL_Log("%d instructions per frame", m_ticks_per_frame);
           break;
+        case SDLK_TAB:
+          SetTurbo(!m_turbo);
+          SDL_Log("Turbo %s", m_turbo ? "on" : "off");
+          break;
+        case SDLK_BACKSPACE:
+          m_rewinding = !LockedByMovie();
+          break;
+        default: {
+          /* F1 to F8 load a slot, and save it with Shift held */
+          const auto slot = event.key.keysym.sym - SDLK_F1 + 1;
+          if (slot < 1 || slot > SAVESTATE_SLOTS) break;
+          if ((event.key.keysym.mod & SDL_KMOD_SHIFT) != 0) {
+            SaveSlot(slot);
+          } else if (!LockedByMovie()) {
+            LoadSlot(slot);
+          }
+          break;
+        }
       }
       break;
-    case SDL_EVENT_QUIT:
-      m_running = false;
+    case SDL_EVENT_KEY_UP:
+      if (event.key.keysym.sym == SDLK_BACKSPACE) m_rewinding = false;
+      break;
+    case SDL_PAUSE_GAME:
+      m_paused = true;
+      break;
+    case SDL_RESUME_GAME:
+      m_paused = false;
+      if (m_fault_reported) {
+        SDL_Log("Held at the fault, reset, rewind or load a state to go on");
+      }
+      break;
+    case SDL_RESET_GAME:
+      Reset();
       break;
   }
 }
 
+/* Shows the menu until it is closed, with the machine held still */
 void Emulator::Pause() {
-  m_paused = true;
-  auto audio_playing = !m_audio.IsPaused();
-  if (audio_playing) {
-    m_audio.PauseTone();
-  }
-  while (m_paused) {
+  if (m_menu_open) return;
+  m_menu_open = true;
+  Send(SDL_PAUSE_GAME);
+  while (m_menu_open && m_running) {
     PollPauseEvents();
-    m_window.DrawMenu(m_memory);
+    m_window.DrawMenu();
     std::this_thread::sleep_for(std::chrono::milliseconds(16));
   }
-  m_window.Draw(m_memory);
-  UnPause(audio_playing);
+  m_window.Draw();
 }
 
 void Emulator::PollPauseEvents() {
@@ -150,132 +436,141 @@ void Emulator::HandlePauseEvent(const SDL_Event& event) {
     case SDL_EVENT_KEY_DOWN:
       switch (m_event.key.keysym.sym) {
         case SDLK_ESCAPE:
-          m_paused = false;
+          m_menu_open = false;
+          Send(SDL_RESUME_GAME);
           return;
       }
       break;
     case SDL_RESUME_GAME:
-      m_paused = false;
+      m_menu_open = false;
+      Send(SDL_RESUME_GAME);
       break;
     case SDL_RESET_GAME:
-      Reset();
+      /* Resets and resumes */
+      m_menu_open = false;
+      Send(SDL_RESET_GAME);
       break;
     case SDL_EVENT_QUIT:
-      m_paused = false;
+      m_menu_open = false;
       m_running = false;
       break;
   }
 }
 
-void Emulator::UnPause(bool resume_audio) {
-  if (resume_audio) {
-    m_audio.StartTone();
-  }
-}
-
-void Emulator::Update() {
-  PollEvents();
-
-  if (m_paused || m_reset) return;
-
-  for (auto tick = 0; tick < TICKS_PER_FRAME / 2; ++tick) {
-    Tick();
-  }
-  UpdateTimers();
-  UpdateSound();
-  for (auto tick = 0; tick < TICKS_PER_FRAME / 2; ++tick) {
-    Tick();
-  }
-  if (m_draw) {
-    m_window.Draw(m_memory);
-    m_draw = false;
-  }
-}
-
-Instruction Emulator::Fetch() {
-  uint16_t instruction =
-      (m_memory.ram.at(m_cpu.pc) << 8) | m_memory.ram.at(m_cpu.pc + 1);
-  m_cpu.pc += 2;
-  return Instruction(instruction);
-}
-
-void Emulator::Tick() {
-  auto instruction = Fetch();
-  switch (instruction.Decode()) {
-    case Opcode::CLS:
-      return m_cpu.CLS(m_memory);
-    case Opcode::RET:
-      return m_cpu.RET(m_memory);
-    case Opcode::SYS:
-      return m_cpu.SYS();
-    case Opcode::JP:
-      return m_cpu.JP(instruction);
-    case Opcode::CALL:
-      return m_cpu.CALL(instruction, m_memory);
-    case Opcode::SE_VX_KK:
-      return m_cpu.SE_VX_KK(instruction);
-    case Opcode::SNE_VX_KK:
-      return m_cpu.SNE_VX_KK(instruction);
-    case Opcode::SE_VX_VY:
-      return m_cpu.SE_VX_VY(instruction);
-    case Opcode::LD_VX_KK:
-      return m_cpu.LD_VX_KK(instruction);
-    case Opcode::ADD_VX_KK:
-      return m_cpu.ADD_VX_KK(instruction);
-    case Opcode::LD_VX_VY:
-      return m_cpu.LD_VX_VY(instruction);
-    case Opcode::OR_VX_VY:
-      return m_cpu.OR_VX_VY(instruction);
-    case Opcode::AND_VX_VY:
-      return m_cpu.AND_VX_VY(instruction);
-    case Opcode::XOR_VX_VY:
-      return m_cpu.XOR_VX_VY(instruction);
-    case Opcode::ADD_VX_VY:
-      return m_cpu.ADD_VX_VY(instruction);
-    case Opcode::SUB_VX_VY:
-      return m_cpu.SUB_VX_VY(instruction);
-    case Opcode::SHR_VX:
-      return m_cpu.SHR_VX(instruction);
-    case Opcode::SUBN_VX_VY:
-      return m_cpu.SUBN_VX_VY(instruction);
-    case Opcode::SHL_VX:
-      return m_cpu.SHL_VX(instruction);
-    case Opcode::SNE_VX_VY:
-      return m_cpu.SNE_VX_VY(instruction);
-    case Opcode::LD_I:
-      return m_cpu.LD_I(instruction);
-    case Opcode::JP_V0:
-      return m_cpu.JP_V0(instruction);
-    case Opcode::RND_VX_KK:
-      return m_cpu.RND_VX_KK(instruction);
-    case Opcode::DRW_VX_VY:
-      m_draw = true;
-      return m_cpu.DRW_VX_VY(instruction, m_memory);
-    case Opcode::SKP_VX:
-      return m_cpu.SKP_VX(instruction, m_input);
-    case Opcode::SKNP_VX:
-      return m_cpu.SKNP_VX(instruction, m_input);
-    case Opcode::LD_VX_DT:
-      return m_cpu.LD_VX_DT(instruction);
-    case Opcode::LD_VX_K:
-      return m_cpu.LD_VX_K(instruction, m_input);
-    case Opcode::LD_DT_VX:
-      return m_cpu.LD_DT_VX(instruction);
-    case Opcode::LD_ST_VX:
-      return m_cpu.LD_ST_VX(instruction);
-    case Opcode::ADD_I_VX:
-      return m_cpu.ADD_I_VX(instruction);
-    case Opcode::LD_F_VX:
-      return m_cpu.LD_F_VX(instruction);
-    case Opcode::LD_B_VX:
-      return m_cpu.LD_B_VX(instruction, m_memory);
-    case Opcode::LD_I_VX:
-      return m_cpu.LD_I_VX(instruction, m_memory);
-    case Opcode::LD_VX_I:
-      return m_cpu.LD_VX_I(instruction, m_memory);
-    default:
-      return;  // Consider unknowns as NOPs
+/* Queues the key events that arrived since frames last ran for the first
+ * slice of the frames about to run. Those frames run back to back once due,
+ * not each at its own time, so every event is already due and holding one
+ * back to a later slice would only add latency. A release queued after a
+ * press of the same key still lands a slice later, so a tap is seen. With
+ * no frames to run, as while rewinding, they are applied at once.
+ */
+void Emulator::QueueKeys(const int frames) {
+  for (const auto& event : m_key_events) {
+    if (frames == 0) {
+      m_machine.input.HandleEvent(event);
+    } else {
+      m_machine.input.QueueEvent(event, 0);
+    }
+  }
+  m_key_events.clear();
+}
+
+/* Runs the frames due, more than one when catching up, and draws once.
+ * While rewinding, steps back as many frames instead. A faulted machine is
+ * held still, and only a reset, a loaded state or rewinding moves it on.
+ */
+void Emulator::Update(const int frames) {
+  QueueKeys(m_rewinding ? 0 : frames);
+  if (m_rewinding) {
+    SilenceTone();
+    for (auto frame = 0; frame < frames; ++frame) {
+      if (!m_rewind.StepBack(m_machine)) break;
+    }
+  } else if (!m_machine.cpu.Faulted()) {
+    for (auto frame = 0; frame < frames; ++frame) {
+      if (!FeedKeys()) {
+        SDL_Log("The movie ended after %zu frames", m_movie.Frames());
+        m_running = false;
+        return;
+      }
+      m_machine.RunFrame(m_ticks_per_frame);
+      QueueSound();
+      ++m_frames;
+      m_rewind.Capture(m_machine);
+      m_autosave.Write(m_machine, m_rom_hash);
+      if (m_machine.cpu.Faulted() || m_machine.cpu.exited) break;
+    }
+  }
+  if (!m_machine.cpu.Faulted()) {
+    m_fault_reported = false;
+  } else if (!m_fault_reported) {
+    m_fault_reported = true;
+    const auto& fault = m_machine.cpu.fault;
+    SDL_Log("Guest fault (%s) at %03X, opcode %04X, address %03X",
+            FaultName(fault.kind), fault.pc, fault.opcode, fault.address);
+    /* Held still here at once, and the menu opened on the other thread */
+    m_paused = true;
+    SDL_Event event{};
+    event.type = SDL_PAUSE_GAME;
+    SDL_PushEvent(&event);
+    return;
+  }
+  if (m_machine.cpu.exited) {
+    SDL_Log("Program exited");
+    m_running = false;
+    return;
+  }
+  if (m_machine.draw) {
+    Publish(false);
+    m_machine.draw = false;
+  }
+}
+
+/* Hands the frame to the renderer with the rows that changed, unless it is
+ * the frame last handed over, as when a sprite was drawn and erased again.
+ * With `whole`, every row is handed over regardless, for when the machine
+ * has been replaced by a reset or a loaded state and the image on screen
+ * no longer belongs to it.
+ */
+void Emulator::Publish(const bool whole) {
+  auto& vram = m_machine.memory.vram;
+  if (whole) vram.Touch(ALL_ROWS);
+  const auto rows = vram.TakeDirty();
+  const auto hash = vram.Hash();
+  if (!whole && (rows == 0 || hash == m_published_hash)) {
+    ++m_frames_unchanged;
+    return;
+  }
+  m_published_hash = hash;
+  auto& frame = m_snapshots.Back();
+  frame.vram = vram;
+  frame.rows = rows;
+  frame.sequence = ++m_frames_published;
+  frame.pressed = m_pressed;
+  m_pressed = 0;
+  m_snapshots.Publish();
+}
+
+/* Uploads the rows of the newest frame that changed. The rows are relative
+ * to the frame published just before it, so if the renderer missed any in
+ * between, every row is uploaded instead.
+ */
+bool Emulator::Present() {
+  uint64_t pressed = 0;
+  if (m_snapshots.Acquire()) {
+    const auto& frame = m_snapshots.Front();
+    const auto missed = frame.sequence - m_presented_sequence - 1;
+    m_frames_superseded += missed;
+    m_window.Update(frame.vram, missed == 0 ? frame.rows : ALL_ROWS);
+    m_presented_sequence = frame.sequence;
+    pressed = frame.pressed;
+  } else if (!m_window.stale) {
+    return false;
   }
+  m_window.Draw();
+  if (pressed != 0) m_latency.Record(pressed, SDL_GetTicksNS());
+  ++m_frames_presented;
+  return true;
 }
 
 Emulator::~Emulator() {
@@ -0,0 +1,103 @@
+#include <cchip8/framebuffer.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cchip8 {
+
+/* 00Cn moves every row down by n, bringing in blank rows at the top */
+void Framebuffer::ScrollDown(const int n) {
+  const auto height = Height();
+  const auto moved = std::min(n, height);
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    if (!Selected(plane)) continue;
+    const auto begin = planes[plane].begin();
+    std::copy_backward(begin, begin + height - moved, begin + height);
+    std::fill(begin, begin + moved, FrameRow{});
+  }
+  Touch(ALL_ROWS);
+}
+
+/* 00Dn, from XO-CHIP, is the same upwards */
+void Framebuffer::ScrollUp(const int n) {
+  const auto height = Height();
+  const auto moved = std::min(n, height);
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    if (!Selected(plane)) continue;
+    const auto begin = planes[plane].begin();
+    std::copy(begin + moved, begin + height, begin);
+    std::fill(begin + height - moved, begin + height, FrameRow{});
+  }
+  Touch(ALL_ROWS);
+}
+
+/* 00FB and 00FC shift each row as one wide integer. n is below a word. */
+void Framebuffer::ScrollRight(const int n) {
+  const auto height = Height();
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    if (!Selected(plane)) continue;
+    for (auto y = 0; y < height; ++y) {
+      auto& row = planes[plane][y];
+      row[1] = hires ? (row[1] >> n) | (row[0] << (ROW_WORD_BITS - n)) : 0;
+      row[0] >>= n;
+    }
+  }
+  Touch(ALL_ROWS);
+}
+
+void Framebuffer::ScrollLeft(const int n) {
+  const auto height = Height();
+  for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+    if (!Selected(plane)) continue;
+    for (auto y = 0; y < height; ++y) {
+      auto& row = planes[plane][y];
+      row[0] = (row[0] << n) | (row[1] >> (ROW_WORD_BITS - n));
+      row[1] <<= n;
+    }
+  }
+  Touch(ALL_ROWS);
+}
+
+int Framebuffer::Span(const int x, const int y, uint8_t& color) const {
+  color = Pixel(x, y);
+  const auto width = Width();
+  auto end = x;
+  while (end < width) {
+    const auto word = end / ROW_WORD_BITS;
+    const auto offset = end % ROW_WORD_BITS;
+    /* The pixels of the word whose colour differs from the first one */
+    uint64_t differ = 0;
+    for (auto plane = 0; plane < NUM_PLANES; ++plane) {
+      const uint64_t lit = ((color >> plane) & 1) != 0 ? ~uint64_t{0} : 0;
+      differ |= planes[plane][y][word] ^ lit;
+    }
+    const auto rest = ROW_WORD_BITS - offset;
+    const auto same = std::min(LeadingZeros(differ << offset), rest);
+    end += same;
+    if (same < rest) break;
+  }
+  return std::min(end, width) - x;
+}
+
+uint64_t Framebuffer::Hash() const {
+  if (m_hash_valid) return m_hash;
+  uint64_t hash = 0xCBF29CE484222325;
+  auto mix = [&hash](const uint64_t word) {
+    for (auto byte = 0; byte < 8; ++byte) {
+      hash ^= (word >> (8 * byte)) & 0xFF;
+      hash *= 0x100000001B3;
+    }
+  };
+  mix(hires ? 1 : 0);
+  const auto height = Height();
+  for (const auto& plane : planes) {
+    for (auto y = 0; y < height; ++y) {
+      for (const auto word : plane[y]) mix(word);
+    }
+  }
+  m_hash = hash;
+  m_hash_valid = true;
+  return hash;
+}
+
+}  // namespace cchip8
@@ -1,27 +1,130 @@
 #include <SDL.h>
 #include <cchip8/input.h>
 
-namespace cchip8 {
-
-void Input::Reset() { m_keyboard.fill(false); }
+#include <algorithm>
 
-bool Input::IsDown(uint8_t key) const {
-  return m_keyboard.at(m_keycode_map.at(key));
-}
+namespace cchip8 {
 
-bool Input::IsUp(uint8_t key) const {
-  return !m_keyboard.at(m_keycode_map.at(key));
+void Input::Reset() {
+  m_down = 0;
+  m_wait_pressed = 0;
+  m_released = NUM_KEYS;
+  m_frame_pressed = 0;
+  m_queued = 0;
 }
 
 void Input::HandleEvent(const SDL_Event &event) {
-  auto keycode = static_cast<size_t>(event.key.keysym.sym);
+  const auto key = KeyOf(event.key.keysym.sym);
+  if (key == NUM_KEYS) return;
   switch (event.type) {
     case SDL_EVENT_KEY_DOWN:
-      if (keycode < KEYBOARD_SIZE) m_keyboard.at(keycode) = true;
+      Press(key);
       break;
     case SDL_EVENT_KEY_UP:
-      if (keycode < KEYBOARD_SIZE) m_keyboard.at(keycode) = false;
+      Release(key);
       break;
   }
 }
+
+/* Each key's changes are kept in order whatever slices they are given, and
+ * a key tapped within one slice is held down until the next, so that the
+ * program can see it
+ */
+void Input::QueueEvent(const SDL_Event &event, int slice) {
+  const auto key = KeyOf(event.key.keysym.sym);
+  const bool down = event.type == SDL_EVENT_KEY_DOWN;
+  if (key == NUM_KEYS || (!down && event.type != SDL_EVENT_KEY_UP)) return;
+  slice = std::max(slice, 0);
+  for (size_t i = 0; i < m_queued; ++i) {
+    const auto &queued = m_queue[i];
+    if (queued.key != key) continue;
+    slice = std::max(slice, queued.slice + (queued.down && !down ? 1 : 0));
+  }
+  if (m_queued == INPUT_QUEUE_SIZE) {
+    Apply(m_queue[0]);
+    std::move(m_queue.begin() + 1, m_queue.end(), m_queue.begin());
+    --m_queued;
+  }
+  m_queue[m_queued++] = KeyChange{slice, static_cast<uint8_t>(key), down};
+}
+
+void Input::ApplyQueued(const int slice) {
+  size_t kept = 0;
+  for (size_t i = 0; i < m_queued; ++i) {
+    if (m_queue[i].slice <= slice) {
+      Apply(m_queue[i]);
+    } else {
+      m_queue[kept++] = m_queue[i];
+    }
+  }
+  m_queued = kept;
+}
+
+void Input::EndFrame(const int slices) {
+  for (size_t i = 0; i < m_queued; ++i) {
+    m_queue[i].slice = std::max(m_queue[i].slice - slices, 0);
+  }
+}
+
+void Input::Apply(const KeyChange &change) {
+  if (change.down) {
+    Press(change.key);
+  } else {
+    Release(change.key);
+  }
+}
+
+void Input::Press(const int key) {
+  m_down |= 1 << key;
+  m_wait_pressed |= 1 << key;
+  m_frame_pressed |= 1 << key;
+}
+
+void Input::Release(const int key) {
+  m_down &= ~(1 << key);
+  if (m_released == NUM_KEYS && ((m_wait_pressed >> key) & 1) != 0) {
+    m_released = key;
+  }
+}
+
+/* Presses come before releases, so a key pressed here can also end a wait
+ * that started before it
+ */
+void Input::SetKeys(const uint16_t keys) {
+  const auto down = m_down;
+  for (auto key = 0; key < NUM_KEYS; ++key) {
+    const bool now = ((keys >> key) & 1) != 0;
+    if (now && ((down >> key) & 1) == 0) Press(key);
+  }
+  for (auto key = 0; key < NUM_KEYS; ++key) {
+    const bool now = ((keys >> key) & 1) != 0;
+    if (!now && ((down >> key) & 1) != 0) Release(key);
+  }
+}
+
+uint16_t Input::TakeFrameKeys() {
+  const uint16_t keys = m_down | m_frame_pressed;
+  m_frame_pressed = 0;
+  return keys;
+}
+
+void Input::WaitForKey() {
+  m_wait_pressed = m_down;
+  m_released = NUM_KEYS;
+}
+
+bool Input::TakeRelease(uint8_t &key) {
+  if (m_released == NUM_KEYS) return false;
+  key = m_released;
+  m_released = NUM_KEYS;
+  m_wait_pressed = 0;
+  return true;
+}
+
+int Input::KeyOf(const SDL_Keycode keycode) const {
+  for (auto key = 0; key < NUM_KEYS; ++key) {
+    if (m_keycode_map[key] == keycode) return key;
+  }
+  return NUM_KEYS;
+}
 }  // namespace cchip8
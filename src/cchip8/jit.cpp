@@ -0,0 +1,452 @@
+#include <cchip8/cpu.h>
+#include <cchip8/instruction.h>
+#include <cchip8/jit.h>
+#include <cchip8/machine.h>
+#include <cchip8/memory.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#if defined(CCHIP8_ENABLE_JIT) && defined(__x86_64__) && \
+    (defined(__linux__) || defined(__APPLE__))
+#define CCHIP8_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define CCHIP8_JIT_SUPPORTED 0
+#endif
+
+namespace cchip8 {
+
+namespace {
+
+/*
+ * Just enough of an x86-64 assembler for the block translator. Generated code
+ * follows the System V calling convention: rdi holds the Cpu pointer, esi the
+ * instruction budget, and eax returns the number of instructions executed.
+ * Every memory operand is [rdi + disp32] into the Cpu.
+ */
+class Emitter {
+ public:
+  enum Reg : uint8_t { EAX = 0, ECX = 1, EDX = 2 };
+
+  const std::vector<uint8_t>& Code() const { return m_code; }
+
+  /* mov byte [rdi + disp], imm8 */
+  void MovMemImm8(int32_t disp, uint8_t imm) { MemImm8(0xC6, 0, disp, imm); }
+  /* add byte [rdi + disp], imm8 */
+  void AddMemImm8(int32_t disp, uint8_t imm) { MemImm8(0x80, 0, disp, imm); }
+  /* cmp byte [rdi + disp], imm8 */
+  void CmpMemImm8(int32_t disp, uint8_t imm) { MemImm8(0x80, 7, disp, imm); }
+  /* mov r8, byte [rdi + disp] */
+  void Load8(Reg reg, int32_t disp) { RegMem(0x8A, reg, disp); }
+  /* mov byte [rdi + disp], r8 */
+  void Store8(int32_t disp, Reg reg) { RegMem(0x88, reg, disp); }
+  /* op byte [rdi + disp], r8 */
+  void OrMem8(int32_t disp, Reg reg) { RegMem(0x08, reg, disp); }
+  void AndMem8(int32_t disp, Reg reg) { RegMem(0x20, reg, disp); }
+  void XorMem8(int32_t disp, Reg reg) { RegMem(0x30, reg, disp); }
+  /* op r8, byte [rdi + disp] */
+  void Add8(Reg reg, int32_t disp) { RegMem(0x02, reg, disp); }
+  void Sub8(Reg reg, int32_t disp) { RegMem(0x2A, reg, disp); }
+  void Cmp8(Reg reg, int32_t disp) { RegMem(0x3A, reg, disp); }
+  /* setc / setae byte [rdi + disp] */
+  void SetcMem(int32_t disp) { Op({0x0F, 0x92}, 0, disp); }
+  void SetaeMem(int32_t disp) { Op({0x0F, 0x93}, 0, disp); }
+  /* and al, imm8 / shr al, imm8 */
+  void AndAlImm8(uint8_t imm) { Bytes({0x24, imm}); }
+  void ShrAlImm8(uint8_t imm) { Bytes({0xC0, 0xE8, imm}); }
+  /* shr / shl byte [rdi + disp], 1 */
+  void ShrMem8(int32_t disp) { Op({0xD0}, 5, disp); }
+  void ShlMem8(int32_t disp) { Op({0xD0}, 4, disp); }
+  /* mov word [rdi + disp], imm16 */
+  void MovMemImm16(int32_t disp, uint16_t imm) {
+    Op({0x66, 0xC7}, 0, disp);
+    Imm(imm, 2);
+  }
+  /* movzx eax, byte [rdi + disp] */
+  void MovzxEax8(int32_t disp) { Op({0x0F, 0xB6}, EAX, disp); }
+  /* add word [rdi + disp], ax */
+  void AddMem16Ax(int32_t disp) { Op({0x66, 0x01}, EAX, disp); }
+  /* mov word [rdi + disp], ax */
+  void StoreAx(int32_t disp) { Op({0x66, 0x89}, EAX, disp); }
+  /* mov r32, imm32 */
+  void MovImm32(Reg reg, uint32_t imm) {
+    m_code.push_back(0xB8 + reg);
+    Imm(imm, 4);
+  }
+  /* cmove / cmovne eax, ecx */
+  void CmoveEaxEcx() { Bytes({0x0F, 0x44, 0xC1}); }
+  void CmovneEaxEcx() { Bytes({0x0F, 0x45, 0xC1}); }
+  /* dec esi */
+  void DecEsi() { Bytes({0xFF, 0xCE}); }
+  /* jnz rel8, returns the offset of the displacement to patch */
+  size_t Jnz() {
+    Bytes({0x75, 0x00});
+    return m_code.size() - 1;
+  }
+  void PatchJump(size_t at) {
+    m_code.at(at) = static_cast<uint8_t>(m_code.size() - at - 1);
+  }
+  void Ret() { m_code.push_back(0xC3); }
+
+ private:
+  void Bytes(std::initializer_list<uint8_t> bytes) {
+    m_code.insert(m_code.end(), bytes);
+  }
+  void Imm(uint32_t value, int size) {
+    for (auto i = 0; i < size; ++i) m_code.push_back((value >> (i * 8)) & 0xFF);
+  }
+  /* mod = 10 (disp32), rm = 111 (rdi) */
+  void ModRm(uint8_t reg, int32_t disp) {
+    m_code.push_back(0x80 | (reg << 3) | 0x07);
+    Imm(static_cast<uint32_t>(disp), 4);
+  }
+  void Op(std::initializer_list<uint8_t> opcode, uint8_t reg, int32_t disp) {
+    Bytes(opcode);
+    ModRm(reg, disp);
+  }
+  void RegMem(uint8_t op, Reg reg, int32_t disp) { Op({op}, reg, disp); }
+  void MemImm8(uint8_t op, uint8_t ext, int32_t disp, uint8_t imm) {
+    Op({op}, ext, disp);
+    m_code.push_back(imm);
+  }
+
+  std::vector<uint8_t> m_code{};
+};
+
+constexpr int32_t V(uint8_t reg) {
+  return static_cast<int32_t>(offsetof(Cpu, registers) + reg);
+}
+constexpr int32_t VF_OFFSET = V(Registers::VF);
+constexpr int32_t I_OFFSET = static_cast<int32_t>(offsetof(Cpu, I));
+constexpr int32_t PC_OFFSET = static_cast<int32_t>(offsetof(Cpu, pc));
+
+/* Sets pc and returns the number of instructions executed */
+void EmitExit(Emitter& e, uint16_t pc, uint32_t executed) {
+  e.MovMemImm16(PC_OFFSET, pc);
+  e.MovImm32(Emitter::EAX, executed);
+  e.Ret();
+}
+
+/* Ends the block with pc set to `next`, or to `next + 2` if the last
+ * comparison set the flags for a skip.
+ */
+void EmitSkipExit(Emitter& e, uint16_t next, uint32_t executed, bool equal) {
+  e.MovImm32(Emitter::EAX, next);
+  e.MovImm32(Emitter::ECX, next + 2);
+  if (equal) {
+    e.CmoveEaxEcx();
+  } else {
+    e.CmovneEaxEcx();
+  }
+  e.StoreAx(PC_OFFSET);
+  e.MovImm32(Emitter::EAX, executed);
+  e.Ret();
+}
+
+enum class Kind { Straight, Terminator, Untranslatable };
+
+Kind Classify(const Opcode opcode) {
+  switch (opcode) {
+    case Opcode::SYS:
+    case Opcode::LD_VX_KK:
+    case Opcode::ADD_VX_KK:
+    case Opcode::LD_VX_VY:
+    case Opcode::OR_VX_VY:
+    case Opcode::AND_VX_VY:
+    case Opcode::XOR_VX_VY:
+    case Opcode::ADD_VX_VY:
+    case Opcode::SUB_VX_VY:
+    case Opcode::SUBN_VX_VY:
+    case Opcode::SHR_VX:
+    case Opcode::SHL_VX:
+    case Opcode::LD_I:
+    case Opcode::ADD_I_VX:
+      return Kind::Straight;
+    case Opcode::JP:
+    case Opcode::SE_VX_KK:
+    case Opcode::SNE_VX_KK:
+    case Opcode::SE_VX_VY:
+    case Opcode::SNE_VX_VY:
+      return Kind::Terminator;
+    default:
+      return Kind::Untranslatable;
+  }
+}
+
+/*
+ * Emits a single instruction that leaves pc untouched. The register
+ * semantics, including the order in which VF and Vx are written when x is
+ * F, mirror cpu.cpp exactly for the given quirks profile.
+ */
+template <typename Quirks>
+void EmitStraight(Emitter& e, const DecodedInstruction& decoded) {
+  const auto& i = decoded.instruction;
+  const auto vx = V(i.x());
+  const auto vy = V(i.y());
+  switch (decoded.opcode) {
+    case Opcode::SYS:
+      return;
+    case Opcode::LD_VX_KK:
+      e.MovMemImm8(vx, i.kk());
+      return;
+    case Opcode::ADD_VX_KK:
+      e.AddMemImm8(vx, i.kk());
+      return;
+    case Opcode::LD_VX_VY:
+      e.Load8(Emitter::EAX, vy);
+      e.Store8(vx, Emitter::EAX);
+      return;
+    case Opcode::OR_VX_VY:
+      e.Load8(Emitter::EAX, vy);
+      e.OrMem8(vx, Emitter::EAX);
+      if constexpr (Quirks::vf_reset) e.MovMemImm8(VF_OFFSET, 0);
+      return;
+    case Opcode::AND_VX_VY:
+      e.Load8(Emitter::EAX, vy);
+      e.AndMem8(vx, Emitter::EAX);
+      if constexpr (Quirks::vf_reset) e.MovMemImm8(VF_OFFSET, 0);
+      return;
+    case Opcode::XOR_VX_VY:
+      e.Load8(Emitter::EAX, vy);
+      e.XorMem8(vx, Emitter::EAX);
+      if constexpr (Quirks::vf_reset) e.MovMemImm8(VF_OFFSET, 0);
+      return;
+    case Opcode::ADD_VX_VY:
+      e.Load8(Emitter::EAX, vx);
+      e.Add8(Emitter::EAX, vy);
+      e.Store8(vx, Emitter::EAX);
+      e.SetcMem(VF_OFFSET);
+      return;
+    case Opcode::SUB_VX_VY:
+      e.Load8(Emitter::EAX, vx);
+      e.Cmp8(Emitter::EAX, vy);
+      e.SetaeMem(VF_OFFSET);
+      e.Load8(Emitter::EAX, vx);
+      e.Sub8(Emitter::EAX, vy);
+      e.Store8(vx, Emitter::EAX);
+      return;
+    case Opcode::SUBN_VX_VY:
+      e.Load8(Emitter::EAX, vy);
+      e.Cmp8(Emitter::EAX, vx);
+      e.SetaeMem(VF_OFFSET);
+      e.Load8(Emitter::EAX, vx);
+      e.Sub8(Emitter::EAX, vy);
+      e.Store8(vx, Emitter::EAX);
+      return;
+    case Opcode::SHR_VX:
+      if constexpr (Quirks::shift_vy) {
+        e.Load8(Emitter::EAX, vy);
+        e.Store8(vx, Emitter::EAX);
+      }
+      e.Load8(Emitter::EAX, vx);
+      e.AndAlImm8(0x01);
+      e.Store8(VF_OFFSET, Emitter::EAX);
+      e.ShrMem8(vx);
+      return;
+    case Opcode::SHL_VX:
+      if constexpr (Quirks::shift_vy) {
+        e.Load8(Emitter::EAX, vy);
+        e.Store8(vx, Emitter::EAX);
+      }
+      e.Load8(Emitter::EAX, vx);
+      e.ShrAlImm8(7);
+      e.Store8(VF_OFFSET, Emitter::EAX);
+      e.ShlMem8(vx);
+      return;
+    case Opcode::LD_I:
+      e.MovMemImm16(I_OFFSET, i.addr());
+      return;
+    case Opcode::ADD_I_VX:
+      e.MovzxEax8(vx);
+      e.AddMem16Ax(I_OFFSET);
+      return;
+    default:
+      return;
+  }
+}
+
+/* Emits an instruction that ends the block by setting pc. `next` is the
+ * address following it.
+ */
+void EmitTerminator(Emitter& e, const DecodedInstruction& decoded,
+                    uint16_t next, uint32_t executed) {
+  const auto& i = decoded.instruction;
+  switch (decoded.opcode) {
+    case Opcode::JP:
+      EmitExit(e, i.addr(), executed);
+      return;
+    case Opcode::SE_VX_KK:
+    case Opcode::SNE_VX_KK:
+      e.CmpMemImm8(V(i.x()), i.kk());
+      EmitSkipExit(e, next, executed, decoded.opcode == Opcode::SE_VX_KK);
+      return;
+    case Opcode::SE_VX_VY:
+    case Opcode::SNE_VX_VY:
+      e.Load8(Emitter::EDX, V(i.x()));
+      e.Cmp8(Emitter::EDX, V(i.y()));
+      EmitSkipExit(e, next, executed, decoded.opcode == Opcode::SE_VX_VY);
+      return;
+    default:
+      return;
+  }
+}
+
+#if CCHIP8_JIT_SUPPORTED
+size_t PageSize() {
+  static const auto size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+#endif
+
+}  // namespace
+
+Jit::Jit() {
+  SetQuirks(Quirks::Modern);
+#if CCHIP8_JIT_SUPPORTED
+  void* code = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (code != MAP_FAILED) m_code = static_cast<uint8_t*>(code);
+#endif
+}
+
+Jit::~Jit() {
+#if CCHIP8_JIT_SUPPORTED
+  if (m_code != nullptr) munmap(m_code, JIT_CODE_SIZE);
+#endif
+}
+
+bool Jit::Supported() { return CCHIP8_JIT_SUPPORTED; }
+
+void Jit::Flush() {
+  m_blocks.fill(Block{});
+  m_code_used = 0;
+}
+
+void Jit::SetQuirks(const Quirks quirks) {
+  m_translate = WithQuirks(quirks, [](auto profile) {
+    return &Jit::Translate<decltype(profile)>;
+  });
+  Flush();
+}
+
+template <typename Quirks>
+Jit::Block Jit::Translate(Memory& memory, const uint16_t pc) {
+  Emitter e;
+  uint32_t executed = 0;
+  uint16_t address = pc;
+  bool terminated = false;
+
+  while (executed < JIT_MAX_BLOCK_LENGTH && address < RAM_SIZE - 1) {
+    const auto& decoded = memory.Decode(address);
+    const auto kind = Classify(decoded.opcode);
+    if (kind == Kind::Untranslatable) break;
+    /* A skip over F000 nnnn steps four bytes, which EmitSkipExit does not
+     * know about, so the interpreter takes it
+     */
+    if (kind == Kind::Terminator && decoded.opcode != Opcode::JP &&
+        memory.Decode(address + 2).opcode == Opcode::LD_I_LONG) {
+      break;
+    }
+    if (executed > 0) {
+      /* Leave right before this instruction once the budget is spent */
+      e.DecEsi();
+      auto skip = e.Jnz();
+      EmitExit(e, address, executed);
+      e.PatchJump(skip);
+    }
+    const uint16_t next = address + 2;
+    ++executed;
+    if (kind == Kind::Terminator) {
+      EmitTerminator(e, decoded, next, executed);
+      terminated = true;
+      break;
+    }
+    EmitStraight<Quirks>(e, decoded);
+    address = next;
+  }
+  if (executed == 0) return Block{nullptr, BlockState::Interpret};
+  if (!terminated) EmitExit(e, address, executed);
+
+#if CCHIP8_JIT_SUPPORTED
+  const auto& code = e.Code();
+  if (m_code == nullptr) return Block{nullptr, BlockState::Interpret};
+  if (m_code_used + code.size() > JIT_CODE_SIZE) {
+    Flush();
+  }
+  /* Only the pages the block lands on are made writable. Blocks sharing
+   * them cannot run meanwhile, which is fine on this one thread.
+   */
+  auto* fn = m_code + m_code_used;
+  auto* pages = m_code + (m_code_used / PageSize()) * PageSize();
+  const auto length = static_cast<size_t>(fn + code.size() - pages);
+  mprotect(pages, length, PROT_READ | PROT_WRITE);
+  std::memcpy(fn, code.data(), code.size());
+  m_code_used += code.size();
+  mprotect(pages, length, PROT_READ | PROT_EXEC);
+  return Block{reinterpret_cast<BlockFn>(fn), BlockState::Translated};
+#else
+  return Block{nullptr, BlockState::Interpret};
+#endif
+}
+
+const Jit::Block& Jit::Lookup(Memory& memory, const uint16_t pc) {
+  if (m_generation != memory.CodeGeneration()) {
+    Flush();
+    m_generation = memory.CodeGeneration();
+  }
+  if (m_blocks.at(pc).state == BlockState::Untranslated) {
+    /* Translating may flush every block, so assign only afterwards */
+    auto block = (this->*m_translate)(memory, pc);
+    m_blocks.at(pc) = block;
+  }
+  return m_blocks.at(pc);
+}
+
+int Jit::RunCompare(Machine& machine, const Block& block, int budget) {
+  const Cpu before = machine.cpu;
+  auto executed = block.fn(&machine.cpu, budget);
+  const Cpu translated = machine.cpu;
+
+  machine.cpu = before;
+  for (auto i = 0; i < executed; ++i) machine.Tick();
+
+  const auto& expected = machine.cpu;
+  if (translated.registers != expected.registers ||
+      translated.I != expected.I || translated.pc != expected.pc) {
+    ++m_mismatches;
+    std::cerr << "JIT mismatch in block at " << std::hex << std::setw(3)
+              << before.pc << " after " << std::dec << executed
+              << " instructions: pc " << std::hex << translated.pc << " vs "
+              << expected.pc << ", I " << translated.I << " vs " << expected.I
+              << std::dec << std::endl;
+  }
+  return executed;
+}
+
+int Jit::Run(Machine& machine, int ticks, bool compare) {
+  auto& cpu = machine.cpu;
+  while (ticks > 0 && !cpu.Stopped()) {
+    if (cpu.pc >= RAM_SIZE - 1) {
+      machine.Tick();
+      --ticks;
+      continue;
+    }
+    const auto& block = Lookup(machine.memory, cpu.pc);
+    if (block.state != BlockState::Translated) {
+      machine.Tick();
+      --ticks;
+      continue;
+    }
+    ticks -= compare ? RunCompare(machine, block, ticks)
+                     : block.fn(&cpu, ticks);
+  }
+  return ticks;
+}
+
+}  // namespace cchip8
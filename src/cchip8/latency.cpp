@@ -0,0 +1,15 @@
+#include <cchip8/latency.h>
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cchip8 {
+
+void LatencyProbe::Record(const uint64_t pressed, const uint64_t presented) {
+  const auto latency = presented > pressed ? presented - pressed : 0;
+  m_history.Record(latency);
+  m_max = std::max(m_max, latency);
+  ++m_count;
+}
+
+}  // namespace cchip8
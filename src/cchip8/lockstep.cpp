@@ -0,0 +1,776 @@
+#include <cchip8/cpu.h>
+#include <cchip8/instruction.h>
+#include <cchip8/lockstep.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/random.h>
+#include <cchip8/rom.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace cchip8 {
+
+namespace {
+
+/* Instructions after which lanes may no longer share a pc */
+bool EndsBlock(const Opcode opcode) {
+  switch (opcode) {
+    case Opcode::RET:
+    case Opcode::JP:
+    case Opcode::CALL:
+    case Opcode::SE_VX_KK:
+    case Opcode::SNE_VX_KK:
+    case Opcode::SE_VX_VY:
+    case Opcode::SNE_VX_VY:
+    case Opcode::JP_V0:
+    case Opcode::SKP_VX:
+    case Opcode::SKNP_VX:
+    case Opcode::LD_I_LONG:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IsSkip(const Opcode opcode) {
+  switch (opcode) {
+    case Opcode::SE_VX_KK:
+    case Opcode::SNE_VX_KK:
+    case Opcode::SE_VX_VY:
+    case Opcode::SNE_VX_VY:
+    case Opcode::SKP_VX:
+    case Opcode::SKNP_VX:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/* value where mask is 0xFF, keep where it is 0. Written with bitwise
+ * operations rather than a branch so that the lane loops vectorize.
+ */
+template <typename T, typename U>
+T Select(const uint8_t mask, const U value, const T keep) {
+  const auto bits = static_cast<T>(static_cast<int8_t>(mask));
+  return static_cast<T>((static_cast<T>(value) & bits) | (keep & ~bits));
+}
+
+}  // namespace
+
+Lockstep::Lockstep(const Rom& rom, size_t lanes, Quirks quirks)
+    : m_lanes(lanes),
+      m_stride((lanes + LOCKSTEP_LANE_ALIGN - 1) / LOCKSTEP_LANE_ALIGN *
+               LOCKSTEP_LANE_ALIGN),
+      m_execute(WithQuirks(quirks, [](auto profile) {
+        return &Lockstep::Execute<decltype(profile)>;
+      })) {
+  m_registers.resize(NUM_REGISTERS * m_stride);
+  m_I.resize(m_stride);
+  m_pc.resize(m_stride, PROGRAM_START);
+  m_sp.resize(m_stride);
+  m_delay.resize(m_stride);
+  m_sound.resize(m_stride);
+  m_keys.resize(m_stride);
+  m_wait.resize(m_stride);
+  m_exited.resize(m_stride);
+  m_faults.resize(m_lanes);
+  m_stopped.resize(m_stride);
+  m_stopped_at.resize(m_lanes);
+  m_halted_steps.resize(m_lanes);
+  m_rng.resize(RandomState{}.size() * m_stride);
+  m_memory.resize(m_lanes);
+  for (size_t lane = 0; lane < m_lanes; ++lane) {
+    m_memory.at(lane).LoadProgram(rom, PROGRAM_START);
+    Seed(lane, DEFAULT_SEED + lane);
+  }
+  m_group_at.resize(UINT16_MAX + 1, -1);
+  m_groups.push_back(Group{PROGRAM_START, std::vector<uint8_t>(m_stride), {}});
+  for (size_t lane = 0; lane < m_lanes; ++lane) {
+    m_groups.front().mask.at(lane) = 0xFF;
+    m_groups.front().lanes.push_back(lane);
+  }
+}
+
+void Lockstep::Seed(size_t lane, uint64_t seed) {
+  const auto state = SeedRandom(seed);
+  for (size_t word = 0; word < state.size(); ++word) {
+    m_rng.at((word * m_stride) + lane) = state.at(word);
+  }
+}
+
+Cpu Lockstep::LaneCpu(size_t lane) const {
+  Cpu cpu;
+  for (auto reg = 0; reg < NUM_REGISTERS; ++reg) {
+    cpu.registers.at(reg) = m_registers.at((reg * m_stride) + lane);
+  }
+  cpu.I = m_I.at(lane);
+  cpu.pc = m_pc.at(lane);
+  cpu.sp = m_sp.at(lane);
+  cpu.t_delay = m_delay.at(lane);
+  cpu.t_sound = m_sound.at(lane);
+  cpu.halted = m_wait.at(lane) != 0;
+  cpu.exited = m_exited.at(lane) != 0;
+  cpu.fault = m_faults.at(lane);
+  for (size_t word = 0; word < cpu.rng.size(); ++word) {
+    cpu.rng.at(word) = m_rng.at((word * m_stride) + lane);
+  }
+  return cpu;
+}
+
+void Lockstep::StoreLaneCpu(size_t lane, const Cpu& cpu) {
+  for (auto reg = 0; reg < NUM_REGISTERS; ++reg) {
+    m_registers.at((reg * m_stride) + lane) = cpu.registers.at(reg);
+  }
+  m_I.at(lane) = cpu.I;
+  m_pc.at(lane) = cpu.pc;
+  m_sp.at(lane) = cpu.sp;
+  m_delay.at(lane) = cpu.t_delay;
+  m_sound.at(lane) = cpu.t_sound;
+  m_exited.at(lane) = cpu.exited;
+  m_faults.at(lane) = cpu.fault;
+  for (size_t word = 0; word < cpu.rng.size(); ++word) {
+    m_rng.at((word * m_stride) + lane) = cpu.rng.at(word);
+  }
+  if (cpu.exited || cpu.Faulted()) {
+    m_stopped.at(lane) = 0xFF;
+    m_stopped_at.at(lane) = m_steps;
+    m_stopping = true;
+  }
+}
+
+uint64_t Lockstep::Executed(size_t lane) const {
+  const auto steps = Stopped(lane) ? m_stopped_at.at(lane) : m_steps;
+  return steps - m_halted_steps.at(lane);
+}
+
+/* Takes the lanes that have stopped out of a group, as the scalar Machine
+ * stops ticking a Cpu that has exited or faulted
+ */
+void Lockstep::RemoveStopped(Group& group) {
+  auto stopped = [&](const uint32_t lane) {
+    if (m_stopped[lane] == 0) return false;
+    group.mask[lane] = 0;
+    return true;
+  };
+  auto& lanes = group.lanes;
+  lanes.erase(std::remove_if(lanes.begin(), lanes.end(), stopped),
+              lanes.end());
+  /* An emptied group is reclaimed by the next Regroup() */
+  if (lanes.empty()) m_regroup = true;
+}
+
+uint16_t Lockstep::Word(size_t lane, uint16_t pc) const {
+  const auto& ram = m_memory.at(lane).ram;
+  return (ram[pc & RAM_MASK] << 8) | ram[(pc + 1) & RAM_MASK];
+}
+
+/* How far a taken skip at the group's pc moves it: past the next instruction,
+ * which is four bytes long when it is F000 nnnn. Returns 0 when lanes
+ * disagree on what follows because code has been written to.
+ */
+uint8_t Lockstep::SkipLength(const Group& group) const {
+  const uint16_t next = group.pc + 2;
+  auto wide = [&](const uint32_t lane) { return Word(lane, next) == 0xF000; };
+  const bool first = wide(group.lanes.front());
+  if (m_self_modified) {
+    for (const auto lane : group.lanes) {
+      if (wide(lane) != first) return 0;
+    }
+  }
+  return first ? 6 : 4;
+}
+
+void Lockstep::RunFrame(const int ticks) {
+  Run(ticks / 2);
+  UpdateTimers();
+  Run(ticks - (ticks / 2));
+}
+
+void Lockstep::Run(int ticks) {
+  Wake();
+  for (; ticks > 0; --ticks) Step();
+}
+
+/* The lockstep form of Machine::Wake(). A lane's keys only change between
+ * calls to Run(), so this is where a release is first seen.
+ */
+void Lockstep::Wake() {
+  bool woke = false;
+  for (size_t lane = 0; lane < m_lanes; ++lane) {
+    auto& wait = m_wait[lane];
+    if (wait == 0) continue;
+    const uint16_t released = wait & ~m_keys[lane];
+    if (released == 0) {
+      wait |= m_keys[lane];
+      continue;
+    }
+    auto key = 0;
+    while (((released >> key) & 1) == 0) ++key;
+    const Instruction instruction(Word(lane, m_pc[lane]));
+    V(instruction.x())[lane] = key;
+    m_pc[lane] += 2;
+    wait = 0;
+    woke = true;
+  }
+  if (!woke) return;
+  for (auto& group : m_groups) group.branched = true;
+  m_regroup = true;
+}
+
+void Lockstep::UpdateTimers() {
+  uint8_t* delay = m_delay.data();
+  uint8_t* sound = m_sound.data();
+  for (size_t l = 0; l < m_stride; ++l) {
+    delay[l] -= delay[l] > 0;
+    sound[l] -= sound[l] > 0;
+  }
+}
+
+void Lockstep::Step() {
+  ++m_steps;
+  if (m_regroup) Regroup();
+  for (auto& group : m_groups) (this->*m_execute)(group);
+}
+
+/*
+ * Only the groups that ran a branch are split, and only their lanes are
+ * visited. A group whose lanes all went the same way is kept as it is.
+ */
+void Lockstep::Regroup() {
+  m_regroup = false;
+  const uint16_t* pc = m_pc.data();
+
+  for (size_t index = 0; index < m_groups.size(); ++index) {
+    const auto& group = m_groups[index];
+    if (!group.branched && m_group_at[group.pc] < 0) {
+      m_group_at[group.pc] = index;
+    }
+  }
+  for (size_t index = 0; index < m_groups.size(); ++index) {
+    auto& group = m_groups[index];
+    if (!group.branched || group.lanes.empty()) continue;
+    group.branched = false;
+    const auto target = pc[group.lanes.front()];
+    bool converged = m_group_at[target] < 0;
+    for (const auto lane : group.lanes) converged &= pc[lane] == target;
+    if (converged) {
+      group.pc = target;
+      m_group_at[target] = index;
+      continue;
+    }
+    for (const auto lane : group.lanes) group.mask[lane] = 0;
+    m_loose.insert(m_loose.end(), group.lanes.begin(), group.lanes.end());
+    group.lanes.clear();
+  }
+
+  for (const auto lane : m_loose) {
+    auto& index = m_group_at[pc[lane]];
+    if (index < 0) {
+      index = m_groups.size();
+      if (m_spare.empty()) {
+        m_groups.push_back(Group{0, std::vector<uint8_t>(m_stride), {}});
+      } else {
+        m_groups.push_back(std::move(m_spare.back()));
+        m_spare.pop_back();
+      }
+      m_groups.back().pc = pc[lane];
+    }
+    auto& group = m_groups[index];
+    group.mask[lane] = 0xFF;
+    group.lanes.push_back(lane);
+  }
+  m_loose.clear();
+
+  size_t kept = 0;
+  for (auto& group : m_groups) {
+    m_group_at[group.pc] = -1;
+    if (group.lanes.empty()) {
+      m_spare.push_back(std::move(group));
+    } else {
+      std::swap(m_groups[kept++], group);
+    }
+  }
+  m_groups.resize(kept);
+}
+
+template <typename Quirks>
+void Lockstep::Execute(Group& group) {
+  if (group.lanes.empty()) return;
+  const auto pc = group.pc;
+  if (!MemoryPolicy::InRam(pc, 2)) {
+    /* Machine::TickAs() faults on fetching past the end of RAM */
+    for (const auto lane : group.lanes) {
+      m_faults[lane] = GuestFault{FaultKind::Fetch, pc, 0, pc};
+      m_stopped[lane] = 0xFF;
+      m_stopped_at[lane] = m_steps;
+    }
+    m_stopping = true;
+    RemoveStopped(group);
+    return;
+  }
+  const Instruction instruction(Word(group.lanes.front(), pc));
+  const auto opcode = instruction.Decode();
+  m_code.set(pc);
+  m_code.set((pc + 1) & RAM_MASK);
+
+  /* Once code has been written to, lanes at the same pc may no longer be
+   * looking at the same instruction, so run any that differ on their own.
+   */
+  if (m_self_modified) {
+    auto differs = [&](const uint32_t lane) {
+      const auto word = Word(lane, pc);
+      if (word == instruction.instruction()) return false;
+      group.mask[lane] = 0;
+      const Instruction own(word);
+      ExecuteLane<Quirks>(lane, own, own.Decode());
+      if (m_stopped[lane] == 0) m_loose.push_back(lane);
+      m_regroup = true;
+      return true;
+    };
+    auto& lanes = group.lanes;
+    lanes.erase(std::remove_if(lanes.begin(), lanes.end(), differs),
+                lanes.end());
+  }
+
+  if (!ExecuteVector<Quirks>(group, instruction, opcode)) {
+    for (const auto lane : group.lanes) {
+      ExecuteLane<Quirks>(lane, instruction, opcode);
+    }
+  }
+  if (m_stopping) {
+    m_stopping = false;
+    RemoveStopped(group);
+  }
+  if (EndsBlock(opcode)) {
+    group.branched = true;
+    m_regroup = true;
+  } else if (opcode != Opcode::LD_VX_K && opcode != Opcode::EXIT) {
+    /* Every lane that ran Fx0A or 00FD stopped on it, so the group stays
+     * put
+     */
+    group.pc += 2;
+  }
+}
+
+/*
+ * The vector forms of the instructions that only touch registers, I, pc,
+ * the timers and the keypad. Lanes outside the group are masked so that
+ * every loop body is branch-free. Each lane's statements run in the same
+ * order as in cpu.cpp, which keeps the results identical when x or y is F.
+ */
+template <typename Quirks>
+bool Lockstep::ExecuteVector(const Group& group,
+                             const Instruction& instruction,
+                             const Opcode opcode) {
+  uint16_t* pc = m_pc.data();
+  uint16_t* I = m_I.data();
+  uint8_t* vx = V(instruction.x());
+  uint8_t* vy = V(instruction.y());
+  uint8_t* vf = V(Registers::VF);
+  const uint8_t kk = instruction.kk();
+  const uint16_t addr = instruction.addr();
+  const uint8_t taken = IsSkip(opcode) ? SkipLength(group) : 0;
+  if (IsSkip(opcode) && taken == 0) return false;
+
+  switch (opcode) {
+    case Opcode::JP:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] = Select(m, addr, pc[l]);
+      });
+      return true;
+    case Opcode::JP_V0: {
+      const uint8_t* v0 = V(Quirks::jump_vx
+                                ? instruction.x()
+                                : static_cast<uint8_t>(Registers::V0));
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] = Select(m, addr + v0[l], pc[l]);
+      });
+      return true;
+    }
+    case Opcode::SE_VX_KK:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] += m & (vx[l] == kk ? taken : 2);
+      });
+      return true;
+    case Opcode::SNE_VX_KK:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] += m & (vx[l] != kk ? taken : 2);
+      });
+      return true;
+    case Opcode::SE_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] += m & (vx[l] == vy[l] ? taken : 2);
+      });
+      return true;
+    case Opcode::SNE_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        pc[l] += m & (vx[l] != vy[l] ? taken : 2);
+      });
+      return true;
+    case Opcode::SKP_VX:
+    case Opcode::SKNP_VX: {
+      const uint16_t* keys = m_keys.data();
+      const bool pressed = opcode == Opcode::SKP_VX;
+      ForEach(group, [=](size_t l, uint8_t m) {
+        const bool down = (vx[l] < NUM_KEYS) &
+                          (((keys[l] >> (vx[l] & 0x0F)) & 1) != 0);
+        pc[l] += m & (down == pressed ? taken : 2);
+      });
+      return true;
+    }
+    default:
+      break;
+  }
+
+  switch (opcode) {
+    case Opcode::SYS:
+    case Opcode::LD_VX_KK:
+    case Opcode::ADD_VX_KK:
+    case Opcode::LD_VX_VY:
+    case Opcode::OR_VX_VY:
+    case Opcode::AND_VX_VY:
+    case Opcode::XOR_VX_VY:
+    case Opcode::ADD_VX_VY:
+    case Opcode::SUB_VX_VY:
+    case Opcode::SHR_VX:
+    case Opcode::SUBN_VX_VY:
+    case Opcode::SHL_VX:
+    case Opcode::LD_I:
+    case Opcode::RND_VX_KK:
+    case Opcode::LD_VX_DT:
+    case Opcode::LD_DT_VX:
+    case Opcode::LD_ST_VX:
+    case Opcode::ADD_I_VX:
+    case Opcode::LD_F_VX:
+    case Opcode::LD_HF_VX:
+      ForEach(group, [=](size_t l, uint8_t m) { pc[l] += m & 2; });
+      break;
+    default:
+      return false;
+  }
+
+  switch (opcode) {
+    case Opcode::LD_VX_KK:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] = Select(m, kk, vx[l]);
+      });
+      break;
+    case Opcode::ADD_VX_KK:
+      ForEach(group, [=](size_t l, uint8_t m) { vx[l] += m & kk; });
+      break;
+    case Opcode::LD_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] = Select(m, vy[l], vx[l]);
+      });
+      break;
+    case Opcode::OR_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] |= vy[l] & m;
+        if constexpr (Quirks::vf_reset) vf[l] &= ~m;
+      });
+      break;
+    case Opcode::AND_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] &= vy[l] | ~m;
+        if constexpr (Quirks::vf_reset) vf[l] &= ~m;
+      });
+      break;
+    case Opcode::XOR_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] ^= vy[l] & m;
+        if constexpr (Quirks::vf_reset) vf[l] &= ~m;
+      });
+      break;
+    case Opcode::ADD_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        const unsigned sum = vx[l] + vy[l];
+        vx[l] = Select(m, sum & 0xFF, vx[l]);
+        vf[l] = Select(m, (sum > 0xFF), vf[l]);
+      });
+      break;
+    case Opcode::SUB_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vf[l] = Select(m, (vx[l] >= vy[l]), vf[l]);
+        vx[l] = Select(m, vx[l] - vy[l], vx[l]);
+      });
+      break;
+    case Opcode::SUBN_VX_VY:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vf[l] = Select(m, (vy[l] >= vx[l]), vf[l]);
+        vx[l] = Select(m, vx[l] - vy[l], vx[l]);
+      });
+      break;
+    case Opcode::SHR_VX:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        if constexpr (Quirks::shift_vy) vx[l] = Select(m, vy[l], vx[l]);
+        vf[l] = Select(m, vx[l] & 0x01, vf[l]);
+        vx[l] = Select(m, vx[l] >> 1, vx[l]);
+      });
+      break;
+    case Opcode::SHL_VX:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        if constexpr (Quirks::shift_vy) vx[l] = Select(m, vy[l], vx[l]);
+        vf[l] = Select(m, vx[l] >> 7, vf[l]);
+        vx[l] = Select(m, vx[l] << 1, vx[l]);
+      });
+      break;
+    case Opcode::LD_I:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        I[l] = Select(m, addr, I[l]);
+      });
+      break;
+    case Opcode::RND_VX_KK: {
+      /* NextRandom() from random.h, one lane per element */
+      uint32_t* s0 = m_rng.data();
+      uint32_t* s1 = s0 + m_stride;
+      uint32_t* s2 = s1 + m_stride;
+      uint32_t* s3 = s2 + m_stride;
+      ForEach(group, [=](size_t l, uint8_t m) {
+        const uint32_t result = RotateLeft(s1[l] * 5, 7) * 9;
+        const uint32_t t = s1[l] << 9;
+        const uint32_t c = s2[l] ^ s0[l];
+        const uint32_t d = s3[l] ^ s1[l];
+        const uint32_t b = s1[l] ^ c;
+        const uint32_t a = s0[l] ^ d;
+        s0[l] = Select(m, a, s0[l]);
+        s1[l] = Select(m, b, s1[l]);
+        s2[l] = Select(m, c ^ t, s2[l]);
+        s3[l] = Select(m, RotateLeft(d, 11), s3[l]);
+        vx[l] = Select(m, (result >> 24) & kk, vx[l]);
+      });
+      break;
+    }
+    case Opcode::LD_VX_DT: {
+      const uint8_t* delay = m_delay.data();
+      ForEach(group, [=](size_t l, uint8_t m) {
+        vx[l] = Select(m, delay[l], vx[l]);
+      });
+      break;
+    }
+    case Opcode::LD_DT_VX: {
+      uint8_t* delay = m_delay.data();
+      ForEach(group, [=](size_t l, uint8_t m) {
+        delay[l] = Select(m, vx[l], delay[l]);
+      });
+      break;
+    }
+    case Opcode::LD_ST_VX: {
+      uint8_t* sound = m_sound.data();
+      ForEach(group, [=](size_t l, uint8_t m) {
+        sound[l] = Select(m, vx[l], sound[l]);
+      });
+      break;
+    }
+    case Opcode::ADD_I_VX:
+      ForEach(group, [=](size_t l, uint8_t m) { I[l] += vx[l] & m; });
+      break;
+    case Opcode::LD_F_VX:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        I[l] = Select(m, SPRITES_LOCATION + (vx[l] * SPRITE_SIZE), I[l]);
+      });
+      break;
+    case Opcode::LD_HF_VX:
+      ForEach(group, [=](size_t l, uint8_t m) {
+        I[l] = Select(m, BIG_SPRITES_LOCATION + (vx[l] * BIG_SPRITE_SIZE),
+                      I[l]);
+      });
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+/*
+ * Runs one instruction for a single lane through the scalar Cpu. Only the
+ * keypad, which lanes keep as a bitmask, is handled here.
+ */
+template <typename Quirks>
+void Lockstep::ExecuteLane(size_t lane, const Instruction& instruction,
+                           const Opcode opcode) {
+  auto cpu = LaneCpu(lane);
+  auto& memory = m_memory.at(lane);
+  const auto keys = m_keys.at(lane);
+  auto down = [keys](uint8_t key) {
+    return key < NUM_KEYS && ((keys >> key) & 1) != 0;
+  };
+  cpu.pc += 2;
+
+  switch (opcode) {
+    case Opcode::CLS:
+      cpu.CLS(memory);
+      break;
+    case Opcode::RET:
+      cpu.RET(memory);
+      break;
+    case Opcode::SCD:
+      cpu.SCD(instruction, memory);
+      break;
+    case Opcode::SCU:
+      cpu.SCU(instruction, memory);
+      break;
+    case Opcode::SCR:
+      cpu.SCR(memory);
+      break;
+    case Opcode::SCL:
+      cpu.SCL(memory);
+      break;
+    case Opcode::EXIT:
+      cpu.EXIT();
+      break;
+    case Opcode::LOW:
+      cpu.LOW(memory);
+      break;
+    case Opcode::HIGH:
+      cpu.HIGH(memory);
+      break;
+    case Opcode::SYS:
+      cpu.SYS();
+      break;
+    case Opcode::JP:
+      cpu.JP(instruction);
+      break;
+    case Opcode::CALL:
+      cpu.CALL(instruction, memory);
+      break;
+    case Opcode::SE_VX_KK:
+      cpu.SE_VX_KK(instruction, memory);
+      break;
+    case Opcode::SNE_VX_KK:
+      cpu.SNE_VX_KK(instruction, memory);
+      break;
+    case Opcode::SE_VX_VY:
+      cpu.SE_VX_VY(instruction, memory);
+      break;
+    case Opcode::LD_I_VX_VY: {
+      const auto x = instruction.x();
+      const auto y = instruction.y();
+      const auto length = (x > y ? x - y : y - x) + 1;
+      for (auto i = 0; i < length; ++i) {
+        if (m_code.test(MemoryPolicy::Ram(cpu.I + i))) m_self_modified = true;
+      }
+      cpu.LD_I_VX_VY(instruction, memory);
+      break;
+    }
+    case Opcode::LD_VX_VY_I:
+      cpu.LD_VX_VY_I(instruction, memory);
+      break;
+    case Opcode::LD_VX_KK:
+      cpu.LD_VX_KK(instruction);
+      break;
+    case Opcode::ADD_VX_KK:
+      cpu.ADD_VX_KK(instruction);
+      break;
+    case Opcode::LD_VX_VY:
+      cpu.LD_VX_VY(instruction);
+      break;
+    case Opcode::OR_VX_VY:
+      cpu.OR_VX_VY<Quirks>(instruction);
+      break;
+    case Opcode::AND_VX_VY:
+      cpu.AND_VX_VY<Quirks>(instruction);
+      break;
+    case Opcode::XOR_VX_VY:
+      cpu.XOR_VX_VY<Quirks>(instruction);
+      break;
+    case Opcode::ADD_VX_VY:
+      cpu.ADD_VX_VY(instruction);
+      break;
+    case Opcode::SUB_VX_VY:
+      cpu.SUB_VX_VY(instruction);
+      break;
+    case Opcode::SHR_VX:
+      cpu.SHR_VX<Quirks>(instruction);
+      break;
+    case Opcode::SUBN_VX_VY:
+      cpu.SUBN_VX_VY(instruction);
+      break;
+    case Opcode::SHL_VX:
+      cpu.SHL_VX<Quirks>(instruction);
+      break;
+    case Opcode::SNE_VX_VY:
+      cpu.SNE_VX_VY(instruction, memory);
+      break;
+    case Opcode::LD_I:
+      cpu.LD_I(instruction);
+      break;
+    case Opcode::JP_V0:
+      cpu.JP_V0<Quirks>(instruction);
+      break;
+    case Opcode::RND_VX_KK:
+      cpu.RND_VX_KK(instruction);
+      break;
+    case Opcode::DRW_VX_VY:
+      cpu.DRW_VX_VY<Quirks>(instruction, memory);
+      break;
+    case Opcode::SKP_VX:
+      if (down(cpu.registers.at(instruction.x()))) cpu.Skip(memory);
+      break;
+    case Opcode::SKNP_VX:
+      if (!down(cpu.registers.at(instruction.x()))) cpu.Skip(memory);
+      break;
+    case Opcode::LD_I_LONG:
+      cpu.LD_I_LONG(memory);
+      break;
+    case Opcode::PLANE:
+      cpu.PLANE(instruction, memory);
+      break;
+    case Opcode::LD_VX_DT:
+      cpu.LD_VX_DT(instruction);
+      break;
+    case Opcode::LD_VX_K:
+      /* Halts as Cpu::LD_VX_K does, counting the keys already down */
+      cpu.pc -= 2;
+      if (m_wait.at(lane) == 0) {
+        m_wait.at(lane) = LOCKSTEP_WAITING | keys;
+      } else {
+        ++m_halted_steps.at(lane);
+      }
+      break;
+    case Opcode::LD_DT_VX:
+      cpu.LD_DT_VX(instruction);
+      break;
+    case Opcode::LD_ST_VX:
+      cpu.LD_ST_VX(instruction);
+      break;
+    case Opcode::ADD_I_VX:
+      cpu.ADD_I_VX(instruction);
+      break;
+    case Opcode::LD_F_VX:
+      cpu.LD_F_VX(instruction);
+      break;
+    case Opcode::LD_HF_VX:
+      cpu.LD_HF_VX(instruction);
+      break;
+    case Opcode::LD_B_VX:
+    case Opcode::LD_I_VX: {
+      const auto length = opcode == Opcode::LD_B_VX ? 3 : instruction.x() + 1;
+      for (auto i = 0; i < length; ++i) {
+        const auto address = MemoryPolicy::Ram<Quirks::ram_size>(cpu.I + i);
+        if (m_code.test(address)) m_self_modified = true;
+      }
+      if (opcode == Opcode::LD_B_VX) {
+        cpu.LD_B_VX<Quirks>(instruction, memory);
+      } else {
+        cpu.LD_I_VX<Quirks>(instruction, memory);
+      }
+      break;
+    }
+    case Opcode::LD_VX_I:
+      cpu.LD_VX_I<Quirks>(instruction, memory);
+      break;
+    case Opcode::LD_R_VX:
+      cpu.LD_R_VX(instruction, memory);
+      break;
+    case Opcode::LD_VX_R:
+      cpu.LD_VX_R(instruction, memory);
+      break;
+    default:
+      break;  // Consider unknowns as NOPs
+  }
+  StoreLaneCpu(lane, cpu);
+}
+
+}  // namespace cchip8
@@ -0,0 +1,435 @@
+#include <cchip8/cpu.h>
+#include <cchip8/dispatch.h>
+#include <cchip8/instruction.h>
+#include <cchip8/jit.h>
+#include <cchip8/machine.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <cchip8/superblock.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace cchip8 {
+
+namespace {
+
+/* Calls field(pointer, size) for every field of the saved state in order.
+ * MachineT is Machine or const Machine.
+ */
+template <typename MachineT, typename Field>
+void VisitState(MachineT& machine, Field field) {
+  auto& cpu = machine.cpu;
+  auto& memory = machine.memory;
+  auto visit = [&field](auto& value) { field(&value, sizeof(value)); };
+  visit(cpu.registers);
+  visit(cpu.I);
+  visit(cpu.pc);
+  visit(cpu.sp);
+  visit(cpu.t_delay);
+  visit(cpu.t_sound);
+  visit(cpu.seed);
+  visit(cpu.rng);
+  visit(cpu.fault.kind);
+  visit(cpu.fault.pc);
+  visit(cpu.fault.opcode);
+  visit(cpu.fault.address);
+  visit(cpu.halted);
+  visit(cpu.exited);
+  visit(memory.ram);
+  visit(memory.vram.planes);
+  visit(memory.vram.selected);
+  visit(memory.vram.hires);
+  visit(memory.stack);
+  visit(memory.rpl);
+}
+
+}  // namespace
+
+Machine::Machine() { SetQuirks(m_quirks); }
+
+bool Machine::Load(const Rom& rom) {
+  cpu.Reset();
+  input.Reset();
+  draw = false;
+  sound = 0;
+  stats = MachineStats{};
+  auto loaded = memory.LoadProgram(rom, PROGRAM_START);
+  cpu.pc = PROGRAM_START;
+  return loaded;
+}
+
+void Machine::SaveState(uint8_t* out) const {
+  VisitState(*this, [&out](const void* value, const size_t size) {
+    std::memcpy(out, value, size);
+    out += size;
+  });
+}
+
+void Machine::LoadState(const uint8_t* in) {
+  VisitState(*this, [&in](void* value, const size_t size) {
+    std::memcpy(value, in, size);
+    in += size;
+  });
+  memory.ClearDecodeCache();
+  memory.vram.Touch(ALL_ROWS);
+  /* A key released before the state was loaded must not end its Fx0A */
+  if (cpu.halted) input.WaitForKey();
+  draw = true;
+}
+
+bool Machine::SetBackend(const Backend backend) {
+  const bool jit = backend == Backend::Jit || backend == Backend::JitCompare;
+  if (jit && !Jit::Supported()) {
+    std::cerr << "The JIT is not supported on this build or host." << std::endl;
+    return false;
+  }
+  if (!jit) {
+    m_jit.reset();
+  } else if (m_jit == nullptr) {
+    m_jit = std::make_unique<Jit>();
+    m_jit->SetQuirks(m_quirks);
+  }
+  if (backend != Backend::Superblock) {
+    m_superblocks.reset();
+  } else if (m_superblocks == nullptr) {
+    m_superblocks = std::make_unique<Superblocks>(m_quirks);
+  }
+  m_backend = backend;
+  return true;
+}
+
+void Machine::SetQuirks(const Quirks quirks) {
+  m_quirks = quirks;
+  m_tick = WithQuirks(quirks, [](auto profile) {
+    return &Machine::TickAs<decltype(profile)>;
+  });
+  m_interpret = WithQuirks(quirks, [](auto profile) {
+    return &Machine::Interpret<decltype(profile)>;
+  });
+  if (m_superblocks != nullptr) {
+    m_superblocks = std::make_unique<Superblocks>(quirks);
+  }
+  if (m_jit != nullptr) m_jit->SetQuirks(quirks);
+}
+
+void Machine::UpdateTimers() {
+  if (cpu.t_delay > 0) {
+    --cpu.t_delay;
+  }
+  if (cpu.t_sound > 0) {
+    --cpu.t_sound;
+  }
+}
+
+const DecodedInstruction& Machine::Fetch() {
+  const auto& decoded = memory.Decode(cpu.pc);
+  cpu.pc += 2;
+  return decoded;
+}
+
+void Machine::RunFrame(const int ticks) {
+  sound = 0;
+  for (auto slice = 0; slice < SOUND_SLICES; ++slice) {
+    if (slice == SOUND_SLICES / 2) UpdateTimers();
+    if (cpu.t_sound > 0) sound |= 1 << slice;
+    input.ApplyQueued(slice);
+    Run((ticks * (slice + 1) / SOUND_SLICES) - (ticks * slice / SOUND_SLICES));
+  }
+  input.EndFrame(SOUND_SLICES);
+}
+
+void Machine::Run(int ticks) {
+  stats.ticks += ticks;
+  if (cpu.halted) Wake();
+  while (ticks > 0 && !cpu.Stopped()) {
+    if (m_idle_skip) ticks -= SkipIdle(ticks);
+    const auto chunk =
+        m_idle_skip ? std::min(ticks, IDLE_PROBE_INTERVAL) : ticks;
+    ticks -= chunk - RunBackend(chunk);
+  }
+  if (cpu.halted) {
+    stats.halted += ticks;
+  } else {
+    stats.stopped += ticks;
+  }
+}
+
+/* Returns the ticks left over when the CPU stopped early */
+int Machine::RunBackend(int ticks) {
+  if (m_jit != nullptr) {
+    return m_jit->Run(*this, ticks, m_backend == Backend::JitCompare);
+  }
+  if (m_superblocks != nullptr) {
+    return m_superblocks->Run(*this, ticks);
+  }
+  return (this->*m_interpret)(ticks);
+}
+
+template <typename Quirks>
+int Machine::Interpret(int ticks) {
+  for (; ticks > 0 && !cpu.Stopped(); --ticks) {
+    TickAs<Quirks>();
+  }
+  return ticks;
+}
+
+/* Finishes a halted Fx0A once the keypad has seen a key released. Keys only
+ * change between calls to Run(), so checking on entry is as early as the
+ * release could be noticed.
+ */
+void Machine::Wake() {
+  uint8_t key = 0;
+  if (!input.TakeRelease(key)) return;
+  cpu.registers[memory.Decode(cpu.pc).instruction.x()] = key;
+  cpu.pc += 2;
+  cpu.halted = false;
+}
+
+/*
+ * Timers and the keypad only change between calls to Run(), so a loop that
+ * leaves the CPU in the same state after every pass will keep doing so
+ * until Run() returns. Such a loop is found statically, run twice to check
+ * that its second pass changed nothing, and then every further whole pass
+ * that fits in the budget is skipped. Returns the ticks used, run or
+ * skipped.
+ */
+int Machine::SkipIdle(const int ticks) {
+  uint16_t head = 0;
+  const auto length = FindIdleLoop(cpu.pc, head);
+  if (length == 0 || ticks < 3 * length) return 0;
+
+  auto used = 0;
+  for (; cpu.pc != head && used < length; ++used) Tick();
+  if (cpu.pc != head) return used;
+
+  const auto pass = RunToHead(head, length);
+  used += pass;
+  if (cpu.pc != head) return used;
+  const Cpu once = cpu;
+  const auto again = RunToHead(head, length);
+  used += again;
+  if (again != pass || !cpu.SameState(once)) return used;
+
+  const auto skipped = ((ticks - used) / pass) * pass;
+  stats.skipped += skipped;
+  return used + skipped;
+}
+
+/* Ticks until pc is back at head, for at most length ticks, and returns
+ * how many ran
+ */
+int Machine::RunToHead(const uint16_t head, const int length) {
+  auto ticks = 0;
+  while (ticks < length && !cpu.Faulted()) {
+    Tick();
+    ++ticks;
+    if (cpu.pc == head) break;
+  }
+  return ticks;
+}
+
+/*
+ * Looks for a jump back over pc, at most IDLE_MAX_LOOP_LENGTH instructions
+ * long, whose body only reads registers, timers, the keypad and RAM and only
+ * writes registers and timers. Returns the loop's length in instructions and
+ * sets head to its first address, or returns 0.
+ */
+int Machine::FindIdleLoop(const uint16_t pc, uint16_t& head) {
+  auto safe = [](const Opcode opcode) {
+    switch (opcode) {
+      case Opcode::SYS:
+      case Opcode::SE_VX_KK:
+      case Opcode::SNE_VX_KK:
+      case Opcode::SE_VX_VY:
+      case Opcode::LD_VX_VY_I:
+      case Opcode::LD_VX_KK:
+      case Opcode::ADD_VX_KK:
+      case Opcode::LD_VX_VY:
+      case Opcode::OR_VX_VY:
+      case Opcode::AND_VX_VY:
+      case Opcode::XOR_VX_VY:
+      case Opcode::ADD_VX_VY:
+      case Opcode::SUB_VX_VY:
+      case Opcode::SHR_VX:
+      case Opcode::SUBN_VX_VY:
+      case Opcode::SHL_VX:
+      case Opcode::SNE_VX_VY:
+      case Opcode::LD_I:
+      case Opcode::SKP_VX:
+      case Opcode::SKNP_VX:
+      case Opcode::LD_VX_DT:
+      case Opcode::LD_DT_VX:
+      case Opcode::LD_ST_VX:
+      case Opcode::ADD_I_VX:
+      case Opcode::LD_F_VX:
+      case Opcode::LD_HF_VX:
+      case Opcode::LD_VX_I:
+      case Opcode::LD_VX_R:
+        return true;
+      default:
+        return false;
+    }
+  };
+
+  for (auto i = 0; i < IDLE_MAX_LOOP_LENGTH; ++i) {
+    const uint16_t address = pc + (2 * i);
+    if (!MemoryPolicy::InRam(address, 2)) return 0;
+    const auto& decoded = memory.Decode(address);
+    if (decoded.opcode != Opcode::JP) {
+      if (!safe(decoded.opcode)) return 0;
+      continue;
+    }
+    const auto target = decoded.instruction.addr();
+    const auto distance = address - target;
+    if (target > pc || distance % 2 != 0 ||
+        distance >= 2 * IDLE_MAX_LOOP_LENGTH) {
+      return 0;
+    }
+    for (auto at = target; at < pc; at += 2) {
+      if (!safe(memory.Decode(at).opcode)) return 0;
+    }
+    head = target;
+    return (distance / 2) + 1;
+  }
+  return 0;
+}
+
+void Machine::Tick() { (this->*m_tick)(); }
+
+template <typename Quirks>
+void Machine::TickAs() {
+  if (cpu.Stopped()) return;
+  if (!MemoryPolicy::InRam(cpu.pc, 2)) {
+    cpu.fault = GuestFault{FaultKind::Fetch, cpu.pc, 0, cpu.pc};
+    return;
+  }
+  const auto& decoded = Fetch();
+#ifdef CCHIP8_THREADED_DISPATCH
+  Dispatch<Quirks>::HANDLERS[decoded.instruction.instruction()](
+      *this, decoded.instruction);
+#else
+  Execute<Quirks>(decoded);
+#endif
+}
+
+template <typename Quirks>
+void Machine::Execute(const DecodedInstruction& decoded) {
+  const auto& instruction = decoded.instruction;
+  switch (decoded.opcode) {
+    case Opcode::CLS:
+      draw = true;
+      return cpu.CLS(memory);
+    case Opcode::RET:
+      return cpu.RET(memory);
+    case Opcode::SCD:
+      draw = true;
+      return cpu.SCD(instruction, memory);
+    case Opcode::SCU:
+      draw = true;
+      return cpu.SCU(instruction, memory);
+    case Opcode::SCR:
+      draw = true;
+      return cpu.SCR(memory);
+    case Opcode::SCL:
+      draw = true;
+      return cpu.SCL(memory);
+    case Opcode::EXIT:
+      return cpu.EXIT();
+    case Opcode::LOW:
+      draw = true;
+      return cpu.LOW(memory);
+    case Opcode::HIGH:
+      draw = true;
+      return cpu.HIGH(memory);
+    case Opcode::SYS:
+      return cpu.SYS();
+    case Opcode::JP:
+      return cpu.JP(instruction);
+    case Opcode::CALL:
+      return cpu.CALL(instruction, memory);
+    case Opcode::SE_VX_KK:
+      return cpu.SE_VX_KK(instruction, memory);
+    case Opcode::SNE_VX_KK:
+      return cpu.SNE_VX_KK(instruction, memory);
+    case Opcode::SE_VX_VY:
+      return cpu.SE_VX_VY(instruction, memory);
+    case Opcode::LD_I_VX_VY:
+      return cpu.LD_I_VX_VY(instruction, memory);
+    case Opcode::LD_VX_VY_I:
+      return cpu.LD_VX_VY_I(instruction, memory);
+    case Opcode::LD_VX_KK:
+      return cpu.LD_VX_KK(instruction);
+    case Opcode::ADD_VX_KK:
+      return cpu.ADD_VX_KK(instruction);
+    case Opcode::LD_VX_VY:
+      return cpu.LD_VX_VY(instruction);
+    case Opcode::OR_VX_VY:
+      return cpu.OR_VX_VY<Quirks>(instruction);
+    case Opcode::AND_VX_VY:
+      return cpu.AND_VX_VY<Quirks>(instruction);
+    case Opcode::XOR_VX_VY:
+      return cpu.XOR_VX_VY<Quirks>(instruction);
+    case Opcode::ADD_VX_VY:
+      return cpu.ADD_VX_VY(instruction);
+    case Opcode::SUB_VX_VY:
+      return cpu.SUB_VX_VY(instruction);
+    case Opcode::SHR_VX:
+      return cpu.SHR_VX<Quirks>(instruction);
+    case Opcode::SUBN_VX_VY:
+      return cpu.SUBN_VX_VY(instruction);
+    case Opcode::SHL_VX:
+      return cpu.SHL_VX<Quirks>(instruction);
+    case Opcode::SNE_VX_VY:
+      return cpu.SNE_VX_VY(instruction, memory);
+    case Opcode::LD_I:
+      return cpu.LD_I(instruction);
+    case Opcode::JP_V0:
+      return cpu.JP_V0<Quirks>(instruction);
+    case Opcode::RND_VX_KK:
+      return cpu.RND_VX_KK(instruction);
+    case Opcode::DRW_VX_VY:
+      draw = true;
+      return cpu.DRW_VX_VY<Quirks>(instruction, memory);
+    case Opcode::SKP_VX:
+      return cpu.SKP_VX(instruction, memory, input);
+    case Opcode::SKNP_VX:
+      return cpu.SKNP_VX(instruction, memory, input);
+    case Opcode::LD_I_LONG:
+      return cpu.LD_I_LONG(memory);
+    case Opcode::PLANE:
+      return cpu.PLANE(instruction, memory);
+    case Opcode::LD_VX_DT:
+      return cpu.LD_VX_DT(instruction);
+    case Opcode::LD_VX_K:
+      return cpu.LD_VX_K(input);
+    case Opcode::LD_DT_VX:
+      return cpu.LD_DT_VX(instruction);
+    case Opcode::LD_ST_VX:
+      return cpu.LD_ST_VX(instruction);
+    case Opcode::ADD_I_VX:
+      return cpu.ADD_I_VX(instruction);
+    case Opcode::LD_F_VX:
+      return cpu.LD_F_VX(instruction);
+    case Opcode::LD_HF_VX:
+      return cpu.LD_HF_VX(instruction);
+    case Opcode::LD_B_VX:
+      return cpu.LD_B_VX<Quirks>(instruction, memory);
+    case Opcode::LD_I_VX:
+      return cpu.LD_I_VX<Quirks>(instruction, memory);
+    case Opcode::LD_VX_I:
+      return cpu.LD_VX_I<Quirks>(instruction, memory);
+    case Opcode::LD_R_VX:
+      return cpu.LD_R_VX(instruction, memory);
+    case Opcode::LD_VX_R:
+      return cpu.LD_VX_R(instruction, memory);
+    default:
+      return;  // Consider unknowns as NOPs
+  }
+}
+
+}  // namespace cchip8
@@ -6,14 +6,19 @@
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 
 namespace cchip8 {
 
 void Memory::Reset() {
   ram.fill(0);
-  vram.fill(false);
+  vram = Framebuffer{};
   stack.fill(0);
+  rpl.fill(0);
+  ClearDecodeCache();
   std::copy(SPRITES.begin(), SPRITES.end(), ram.begin() + SPRITES_LOCATION);
+  std::copy(BIG_SPRITES.begin(), BIG_SPRITES.end(),
+            ram.begin() + BIG_SPRITES_LOCATION);
 }
 
 bool Memory::LoadProgram(const Rom& rom, const size_t location) {
@@ -23,6 +28,34 @@ bool Memory::LoadProgram(const Rom& rom, const size_t location) {
   return true;
 }
 
+void Memory::Write(const uint16_t address, const uint8_t value) {
+  ram[address & RAM_MASK] = value;
+  if (m_decoded == nullptr) return;
+  /* An instruction is two bytes, so the byte also belongs to the one cached
+   * at the previous address.
+   */
+  auto& entry = (*m_decoded)[address & RAM_MASK];
+  auto& previous = (*m_decoded)[(address - 1) & RAM_MASK];
+  if (entry.valid || previous.valid) {
+    entry.valid = false;
+    previous.valid = false;
+    ++m_code_generation;
+  }
+}
+
+const DecodedInstruction& Memory::Decode(const uint16_t address) {
+  if (m_decoded == nullptr) {
+    m_decoded = std::make_unique<std::array<DecodedInstruction, RAM_SIZE>>();
+  }
+  auto& entry = (*m_decoded)[address & RAM_MASK];
+  if (!entry.valid) {
+    Instruction instruction((ram[address & RAM_MASK] << 8) |
+                            ram[(address + 1) & RAM_MASK]);
+    entry = DecodedInstruction{instruction, instruction.Decode(), true};
+  }
+  return entry;
+}
+
 void Memory::DumpMem() const {
   for (auto i = 0; i < RAM_SIZE; ++i) {
     if (i % 16 == 0) {
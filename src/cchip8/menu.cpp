@@ -59,13 +59,18 @@ void Menu::Init(const float x, const float y, SDL_Renderer *renderer) {
 }
 
 void Menu::CenterOnYAxis() {
-  m_pos_y = ((DISPLAY_HEIGHT * DISPLAY_SCALE) - m_menu_height) / 2;
+  m_pos_y = (MENU_AREA_HEIGHT - m_menu_height) / 2;
   m_header.rect.y += m_pos_y;
   for (auto &item : m_menuItems) {
     item.rect.y += m_pos_y;
   }
 }
 
+void Menu::Place(const int width, const int height) {
+  m_origin_x = static_cast<float>(width - MENU_AREA_WIDTH) / 2;
+  m_origin_y = static_cast<float>(height - MENU_AREA_HEIGHT) / 2;
+}
+
 void Menu::ResetSelected() {
   m_menuItems.at(m_selected_idx).selected = false;
   m_menuItems.at(0).selected = true;
@@ -74,18 +79,26 @@ void Menu::ResetSelected() {
 void Menu::Display() {
   SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_BLEND);
   SDL_SetRenderDrawColor(m_renderer, 0x00, 0x00, 0x00, 0xDD);
-  SDL_FRect rect{m_pos_x, m_pos_y, MENU_WIDTH, m_menu_height};
+  const auto x = m_origin_x + m_pos_x;
+  SDL_FRect rect{x, m_origin_y + m_pos_y, MENU_WIDTH, m_menu_height};
   SDL_RenderFillRect(m_renderer, &rect);
 
-  SDL_RenderTexture(m_renderer, m_header.texture, nullptr, &m_header.rect);
+  auto placed = [this](SDL_FRect rect) {
+    rect.x += m_origin_x;
+    rect.y += m_origin_y;
+    return rect;
+  };
+  const auto header = placed(m_header.rect);
+  SDL_RenderTexture(m_renderer, m_header.texture, nullptr, &header);
   for (const auto &item : m_menuItems) {
+    const auto text = placed(item.rect);
     if (item.selected) {
       SDL_SetRenderDrawBlendMode(m_renderer, SDL_BLENDMODE_BLEND);
       SDL_SetRenderDrawColor(m_renderer, 0x3A, 0x9B, 0xDC, 0x99);
-      SDL_FRect rect{m_pos_x, item.rect.y, MENU_WIDTH, item.height};
+      SDL_FRect rect{x, text.y, MENU_WIDTH, item.height};
       SDL_RenderFillRect(m_renderer, &rect);
     }
-    SDL_RenderTexture(m_renderer, item.texture, nullptr, &item.rect);
+    SDL_RenderTexture(m_renderer, item.texture, nullptr, &text);
   }
 }
 
@@ -0,0 +1,156 @@
+#include <cchip8/machine.h>
+#include <cchip8/movie.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+namespace cchip8 {
+
+namespace {
+
+template <typename T>
+void Put(std::ostream& out, const T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T Get(std::istream& in) {
+  T value{};
+  in.read(reinterpret_cast<char*>(&value), sizeof(value));
+  return value;
+}
+
+void PutVarint(std::ostream& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.put(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+bool GetVarint(std::istream& in, uint64_t& value) {
+  value = 0;
+  for (auto shift = 0; shift < 64; shift += 7) {
+    const auto byte = in.get();
+    if (byte == std::istream::traits_type::eof()) return false;
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return true;
+  }
+  return false;
+}
+
+uint64_t Mix(uint64_t hash, const uint64_t value) {
+  for (auto byte = 0; byte < 8; ++byte) {
+    hash = (hash ^ ((value >> (8 * byte)) & 0xFF)) * 0x100000001B3;
+  }
+  return hash;
+}
+
+}  // namespace
+
+bool Movie::Save(const std::string& filename) const {
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  Put<uint32_t>(file, MOVIE_MAGIC);
+  Put<uint16_t>(file, MOVIE_VERSION);
+  Put<uint8_t>(file, static_cast<uint8_t>(quirks));
+  Put<uint8_t>(file, 0);
+  Put<uint32_t>(file, ticks_per_frame);
+  Put<uint64_t>(file, seed);
+  Put<uint64_t>(file, rom_hash);
+  for (size_t frame = 0; frame < m_keys.size();) {
+    auto run = frame + 1;
+    while (run < m_keys.size() && m_keys[run] == m_keys[frame]) ++run;
+    Put<uint16_t>(file, m_keys[frame]);
+    PutVarint(file, run - frame);
+    frame = run;
+  }
+  if (!file) {
+    std::cerr << "Could not write movie " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool Movie::Load(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file.is_open()) {
+    std::cerr << "Could not open movie " << filename << std::endl;
+    return false;
+  }
+  const auto magic = Get<uint32_t>(file);
+  const auto version = Get<uint16_t>(file);
+  const auto profile = Get<uint8_t>(file);
+  Get<uint8_t>(file);
+  const auto ticks = Get<uint32_t>(file);
+  const auto movie_seed = Get<uint64_t>(file);
+  const auto movie_rom_hash = Get<uint64_t>(file);
+  auto damaged = [&filename] {
+    std::cerr << "Movie " << filename
+              << " is damaged or from another version" << std::endl;
+    return false;
+  };
+  if (!file || magic != MOVIE_MAGIC || version != MOVIE_VERSION ||
+      profile > static_cast<uint8_t>(Quirks::Modern) ||
+      ticks < MIN_TICKS_PER_FRAME || ticks > MAX_TICKS_PER_FRAME) {
+    return damaged();
+  }
+  std::vector<uint16_t> keys;
+  while (file.peek() != std::istream::traits_type::eof()) {
+    const auto mask = Get<uint16_t>(file);
+    uint64_t run = 0;
+    if (!file || !GetVarint(file, run) || run == 0 ||
+        run > MOVIE_MAX_FRAMES - keys.size()) {
+      return damaged();
+    }
+    keys.insert(keys.end(), run, mask);
+  }
+  seed = movie_seed;
+  rom_hash = movie_rom_hash;
+  quirks = static_cast<Quirks>(profile);
+  ticks_per_frame = static_cast<int>(ticks);
+  m_keys = std::move(keys);
+  return true;
+}
+
+bool Movie::Prepare(const Rom& rom, Machine& machine) const {
+  if (rom.Hash() != rom_hash) {
+    std::cerr << "The movie was recorded with another ROM" << std::endl;
+    return false;
+  }
+  machine.SetQuirks(quirks);
+  if (!machine.Load(rom)) return false;
+  machine.cpu.Seed(seed);
+  return true;
+}
+
+bool Movie::Play(const Rom& rom, const Backend backend,
+                 PlaybackResult& result) const {
+  Machine machine;
+  if (!machine.SetBackend(backend) || !Prepare(rom, machine)) return false;
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t hash = 0xCBF29CE484222325;
+  for (const auto keys : m_keys) {
+    machine.input.SetKeys(keys);
+    machine.RunFrame(ticks_per_frame);
+    hash = Mix(hash, machine.memory.FrameHash());
+  }
+  std::vector<uint8_t> state(Machine::STATE_SIZE);
+  machine.SaveState(state.data());
+  for (const auto byte : state) hash = (hash ^ byte) * 0x100000001B3;
+
+  result.frames = m_keys.size();
+  result.hash = hash;
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return true;
+}
+
+}  // namespace cchip8
@@ -0,0 +1,30 @@
+#include <cchip8/quirks.h>
+
+#include <string>
+
+namespace cchip8 {
+
+const char* QuirksName(const Quirks quirks) {
+  switch (quirks) {
+    case Quirks::Chip8:
+      return "chip8";
+    case Quirks::SuperChip:
+      return "schip";
+    case Quirks::Modern:
+      return "modern";
+  }
+  return "unknown";
+}
+
+bool ParseQuirks(const std::string& name, Quirks& quirks) {
+  for (const auto candidate :
+       {Quirks::Chip8, Quirks::SuperChip, Quirks::Modern}) {
+    if (name == QuirksName(candidate)) {
+      quirks = candidate;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace cchip8
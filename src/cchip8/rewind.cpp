@@ -0,0 +1,169 @@
+#include <cchip8/machine.h>
+#include <cchip8/rewind.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace cchip8 {
+
+namespace {
+
+void PutVarint(std::vector<uint8_t>& out, size_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+size_t GetVarint(const uint8_t*& in) {
+  size_t value = 0;
+  for (auto shift = 0;; shift += 7) {
+    const auto byte = *in++;
+    value |= static_cast<size_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+}
+
+/*
+ * Encodes state XOR base, or state alone when base is null, as pairs of a
+ * run of zero bytes and a run of literal bytes, each run preceded by its
+ * length. A single zero between nonzero bytes stays in the literal run,
+ * where it is cheaper than ending the run.
+ */
+void Encode(const uint8_t* state, const uint8_t* base, const size_t size,
+            std::vector<uint8_t>& out) {
+  out.clear();
+  auto at = [state, base](const size_t i) -> uint8_t {
+    return base == nullptr ? state[i] : state[i] ^ base[i];
+  };
+  /* Most of the state is unchanged from frame to frame, so zero runs are
+   * skipped a word at a time
+   */
+  auto word_is_zero = [state, base](const size_t i) {
+    uint64_t a = 0;
+    uint64_t b = 0;
+    std::memcpy(&a, state + i, sizeof(a));
+    if (base != nullptr) std::memcpy(&b, base + i, sizeof(b));
+    return a == b;
+  };
+  size_t i = 0;
+  while (i < size) {
+    const auto zeros_from = i;
+    while (i + sizeof(uint64_t) <= size && word_is_zero(i)) {
+      i += sizeof(uint64_t);
+    }
+    while (i < size && at(i) == 0) ++i;
+    if (i == size) break;
+    const auto literal_from = i;
+    while (i < size && (at(i) != 0 || (i + 1 < size && at(i + 1) != 0))) {
+      ++i;
+    }
+    PutVarint(out, literal_from - zeros_from);
+    PutVarint(out, i - literal_from);
+    for (auto j = literal_from; j < i; ++j) out.push_back(at(j));
+  }
+}
+
+}  // namespace
+
+Rewind::Rewind()
+    : m_ring(REWIND_BUFFER_SIZE),
+      m_state(Machine::STATE_SIZE),
+      m_next(Machine::STATE_SIZE) {
+  m_encoded.reserve(2 * Machine::STATE_SIZE);
+}
+
+void Rewind::Clear() {
+  m_entries.clear();
+  m_head = 0;
+  m_since_keyframe = 0;
+}
+
+void Rewind::Capture(const Machine& machine) {
+  const auto start = std::chrono::steady_clock::now();
+  machine.SaveState(m_next.data());
+  const bool keyframe = m_entries.empty() ||
+                        m_since_keyframe + 1 >= REWIND_KEYFRAME_INTERVAL;
+  Encode(m_next.data(), keyframe ? nullptr : m_state.data(),
+         Machine::STATE_SIZE, m_encoded);
+  Store(keyframe);
+  std::swap(m_state, m_next);
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  ++m_stats.captures;
+  m_stats.capture_time += elapsed;
+  m_stats.capture_max = std::max<std::chrono::nanoseconds>(
+      m_stats.capture_max, elapsed);
+}
+
+void Rewind::Store(const bool keyframe) {
+  const auto size = m_encoded.size();
+  if (m_head + size > m_ring.size()) m_head = 0;
+  auto overlaps = [this, size](const Entry& entry) {
+    return entry.offset < m_head + size && m_head < entry.offset + entry.size;
+  };
+  while (!m_entries.empty() && overlaps(m_entries.front())) {
+    m_entries.pop_front();
+  }
+  /* A delta cannot be used without the keyframe before it */
+  while (!m_entries.empty() && !m_entries.front().keyframe) {
+    m_entries.pop_front();
+  }
+  std::memcpy(m_ring.data() + m_head, m_encoded.data(), size);
+  m_entries.push_back(Entry{m_head, size, keyframe});
+  m_head += size;
+  m_since_keyframe = keyframe ? 0 : m_since_keyframe + 1;
+}
+
+void Rewind::Apply(const Entry& entry, uint8_t* state) const {
+  const uint8_t* in = m_ring.data() + entry.offset;
+  const uint8_t* end = in + entry.size;
+  size_t at = 0;
+  while (in < end) {
+    at += GetVarint(in);
+    const auto length = GetVarint(in);
+    for (size_t i = 0; i < length; ++i) state[at + i] ^= in[i];
+    in += length;
+    at += length;
+  }
+}
+
+void Rewind::Rebuild() {
+  auto keyframe = m_entries.size() - 1;
+  while (!m_entries[keyframe].keyframe) --keyframe;
+  std::fill(m_state.begin(), m_state.end(), 0);
+  for (auto i = keyframe; i < m_entries.size(); ++i) {
+    Apply(m_entries[i], m_state.data());
+  }
+  m_since_keyframe = static_cast<int>(m_entries.size() - 1 - keyframe);
+}
+
+bool Rewind::StepBack(Machine& machine) {
+  if (m_entries.size() < 2) return false;
+  const auto newest = m_entries.back();
+  m_entries.pop_back();
+  if (newest.keyframe) {
+    Rebuild();
+  } else {
+    Apply(newest, m_state.data());
+    --m_since_keyframe;
+  }
+  const auto& last = m_entries.back();
+  m_head = last.offset + last.size;
+  machine.LoadState(m_state.data());
+  return true;
+}
+
+size_t Rewind::BytesUsed() const {
+  if (m_entries.empty()) return 0;
+  const auto begin = m_entries.front().offset;
+  const auto end = m_entries.back().offset + m_entries.back().size;
+  return end > begin ? end - begin : m_ring.size() - begin + end;
+}
+
+}  // namespace cchip8
@@ -38,4 +38,12 @@ bool Rom::FromFile(const std::string &filename) {
   return m_loaded;
 }
 
+uint64_t Rom::Hash() const {
+  uint64_t hash = 0xCBF29CE484222325;
+  for (size_t i = 0; i < m_romSize; ++i) {
+    hash = (hash ^ m_data[i]) * 0x100000001B3;
+  }
+  return hash;
+}
+
 }  // namespace cchip8
@@ -0,0 +1,197 @@
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/savestate.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define CCHIP8_AUTOSAVE_SUPPORTED 1
+#else
+#define CCHIP8_AUTOSAVE_SUPPORTED 0
+#endif
+
+namespace cchip8 {
+
+namespace {
+
+/* Where the checksum sits in the header, which it ends */
+constexpr size_t CHECKSUM_OFFSET = SAVESTATE_HEADER_SIZE - 8;
+
+template <typename T>
+void Put(uint8_t*& out, const T value) {
+  std::memcpy(out, &value, sizeof(value));
+  out += sizeof(value);
+}
+
+template <typename T>
+T Get(const uint8_t*& in) {
+  T value{};
+  std::memcpy(&value, in, sizeof(value));
+  in += sizeof(value);
+  return value;
+}
+
+/* FNV-1a taken a word at a time, which is plenty to catch a torn write and
+ * keeps checksumming the 64 KB of RAM every frame cheap
+ */
+uint64_t Checksum(const uint8_t* record) {
+  uint64_t hash = 0xCBF29CE484222325;
+  auto mix = [&hash](const uint8_t* data, const size_t size) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word = 0;
+      std::memcpy(&word, data + i, sizeof(word));
+      hash = (hash ^ word) * 0x100000001B3;
+    }
+    for (; i < size; ++i) hash = (hash ^ data[i]) * 0x100000001B3;
+  };
+  mix(record, CHECKSUM_OFFSET);
+  mix(record + SAVESTATE_HEADER_SIZE, Machine::STATE_SIZE);
+  return hash;
+}
+
+/* Checks a record without loading it */
+bool Valid(const uint8_t* in, const uint64_t rom_hash, uint64_t& frame,
+           Quirks& quirks) {
+  const uint8_t* header = in;
+  if (Get<uint32_t>(header) != SAVESTATE_MAGIC) return false;
+  if (Get<uint16_t>(header) != SAVESTATE_VERSION) return false;
+  const auto profile = Get<uint8_t>(header);
+  if (profile > static_cast<uint8_t>(Quirks::Modern)) return false;
+  quirks = static_cast<Quirks>(profile);
+  Get<uint8_t>(header);
+  if (Get<uint64_t>(header) != rom_hash) return false;
+  frame = Get<uint64_t>(header);
+  if (Get<uint32_t>(header) != Machine::STATE_SIZE) return false;
+  return Get<uint64_t>(header) == Checksum(in);
+}
+
+}  // namespace
+
+void WriteSaveState(const Machine& machine, const uint64_t rom_hash,
+                    const uint64_t frame, uint8_t* out) {
+  uint8_t* header = out;
+  Put<uint32_t>(header, SAVESTATE_MAGIC);
+  Put<uint16_t>(header, SAVESTATE_VERSION);
+  Put<uint8_t>(header, static_cast<uint8_t>(machine.GetQuirks()));
+  Put<uint8_t>(header, 0);
+  Put<uint64_t>(header, rom_hash);
+  Put<uint64_t>(header, frame);
+  Put<uint32_t>(header, Machine::STATE_SIZE);
+  machine.SaveState(out + SAVESTATE_HEADER_SIZE);
+  /* Last, so that a record is only ever valid once it is complete */
+  Put<uint64_t>(header, Checksum(out));
+}
+
+bool ReadSaveState(const uint8_t* in, const uint64_t rom_hash,
+                   Machine& machine, uint64_t& frame) {
+  auto quirks = Quirks::Modern;
+  if (!Valid(in, rom_hash, frame, quirks)) return false;
+  machine.SetQuirks(quirks);
+  machine.LoadState(in + SAVESTATE_HEADER_SIZE);
+  return true;
+}
+
+bool SaveStateToFile(const std::string& filename, const Machine& machine,
+                     const uint64_t rom_hash) {
+  std::vector<uint8_t> record(SAVESTATE_SIZE);
+  WriteSaveState(machine, rom_hash, 0, record.data());
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(record.data()), record.size());
+  if (!file) {
+    std::cerr << "Could not write save state " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool LoadStateFromFile(const std::string& filename, const uint64_t rom_hash,
+                       Machine& machine) {
+  std::vector<uint8_t> record(SAVESTATE_SIZE);
+  std::ifstream file(filename, std::ios::binary);
+  file.read(reinterpret_cast<char*>(record.data()), record.size());
+  if (!file) {
+    std::cerr << "Could not read save state " << filename << std::endl;
+    return false;
+  }
+  uint64_t frame = 0;
+  if (!ReadSaveState(record.data(), rom_hash, machine, frame)) {
+    std::cerr << "Save state " << filename
+              << " is damaged, from another version or for another ROM"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+Autosave::~Autosave() { Close(); }
+
+bool Autosave::Open(const std::string& filename) {
+#if CCHIP8_AUTOSAVE_SUPPORTED
+  Close();
+  const auto size = 2 * SAVESTATE_SIZE;
+  m_fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_fd < 0 || ftruncate(m_fd, size) != 0) {
+    std::cerr << "Could not open autosave " << filename << std::endl;
+    Close();
+    return false;
+  }
+  void* data =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+  if (data == MAP_FAILED) {
+    std::cerr << "Could not map autosave " << filename << std::endl;
+    Close();
+    return false;
+  }
+  m_data = static_cast<uint8_t*>(data);
+  m_frame = 0;
+  return true;
+#else
+  std::cerr << "Autosave is not supported on this platform." << std::endl;
+  (void)filename;
+  return false;
+#endif
+}
+
+void Autosave::Write(const Machine& machine, const uint64_t rom_hash) {
+  if (m_data == nullptr) return;
+  ++m_frame;
+  WriteSaveState(machine, rom_hash, m_frame,
+                 m_data + ((m_frame % 2) * SAVESTATE_SIZE));
+}
+
+bool Autosave::Restore(const uint64_t rom_hash, Machine& machine) {
+  if (m_data == nullptr) return false;
+  const uint8_t* newest = nullptr;
+  for (auto record = 0; record < 2; ++record) {
+    const uint8_t* in = m_data + (record * SAVESTATE_SIZE);
+    uint64_t frame = 0;
+    auto quirks = Quirks::Modern;
+    if (Valid(in, rom_hash, frame, quirks) &&
+        (newest == nullptr || frame > m_frame)) {
+      newest = in;
+      m_frame = frame;
+    }
+  }
+  return newest != nullptr &&
+         ReadSaveState(newest, rom_hash, machine, m_frame);
+}
+
+void Autosave::Close() {
+#if CCHIP8_AUTOSAVE_SUPPORTED
+  if (m_data != nullptr) munmap(m_data, 2 * SAVESTATE_SIZE);
+  if (m_fd >= 0) close(m_fd);
+#endif
+  m_data = nullptr;
+  m_fd = -1;
+}
+
+}  // namespace cchip8
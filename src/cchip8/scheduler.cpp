@@ -0,0 +1,44 @@
+#include <cchip8/scheduler.h>
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace cchip8 {
+
+FrameScheduler::FrameScheduler(const int rate, const int max_catch_up)
+    : m_period(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(1.0 / rate))),
+      m_max_catch_up(std::max(max_catch_up, 1)) {}
+
+void FrameScheduler::Start() {
+  m_deadline = Clock::now() + m_period;
+  m_last = Clock::time_point{};
+}
+
+int FrameScheduler::Wait() {
+  const auto spin_from =
+      m_deadline - std::chrono::microseconds(SCHEDULER_SPIN_MARGIN_US);
+  if (Clock::now() < spin_from) std::this_thread::sleep_until(spin_from);
+  auto now = Clock::now();
+  while (now < m_deadline) now = Clock::now();
+
+  int due = 1 + static_cast<int>((now - m_deadline) / m_period);
+  if (due > m_max_catch_up) {
+    m_dropped += due - m_max_catch_up;
+    due = m_max_catch_up;
+    m_deadline = now + m_period;
+  } else {
+    m_deadline += due * m_period;
+  }
+
+  if (m_last != Clock::time_point{}) {
+    m_history.Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_last)
+            .count());
+  }
+  m_last = now;
+  return due;
+}
+
+}  // namespace cchip8
@@ -0,0 +1,313 @@
+#include <cchip8/handlers.h>
+#include <cchip8/instruction.h>
+#include <cchip8/machine.h>
+#include <cchip8/memory.h>
+#include <cchip8/superblock.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+namespace cchip8 {
+
+namespace {
+
+/*
+ * Ops call the handlers directly, so fused sequences compile into a single
+ * function without any fetch, decode or dispatch in between. pc is kept
+ * exactly as the interpreter would have it before every instruction, and a
+ * skip that is taken ends the sequence early.
+ */
+template <Handler First>
+int Fused(Machine &m, const SuperOp &op) {
+  m.cpu.pc = op.address + 2;
+  First(m, op.instructions[0]);
+  return 1;
+}
+
+template <Handler First, Handler Second>
+int Fused(Machine &m, const SuperOp &op) {
+  auto &pc = m.cpu.pc;
+  pc = op.address + 2;
+  First(m, op.instructions[0]);
+  if (pc != op.address + 2) return 1;
+  pc = op.address + 4;
+  Second(m, op.instructions[1]);
+  return 2;
+}
+
+template <Handler First, Handler Second, Handler Third>
+int Fused(Machine &m, const SuperOp &op) {
+  auto &pc = m.cpu.pc;
+  pc = op.address + 2;
+  First(m, op.instructions[0]);
+  if (pc != op.address + 2) return 1;
+  pc = op.address + 4;
+  Second(m, op.instructions[1]);
+  if (pc != op.address + 4) return 2;
+  pc = op.address + 6;
+  Third(m, op.instructions[2]);
+  return 3;
+}
+
+/* Indexed by Opcode, for instructions that are not part of a fusion */
+template <typename Quirks>
+constexpr std::array<SuperOpFn, NUM_OPCODES> SINGLES = {
+    Fused<ExecCLS>,
+    Fused<ExecRET>,
+    Fused<ExecSCD>,
+    Fused<ExecSCU>,
+    Fused<ExecSCR>,
+    Fused<ExecSCL>,
+    Fused<ExecEXIT>,
+    Fused<ExecLOW>,
+    Fused<ExecHIGH>,
+    Fused<ExecSYS>,
+    Fused<ExecJP>,
+    Fused<ExecCALL>,
+    Fused<ExecSE_VX_KK>,
+    Fused<ExecSNE_VX_KK>,
+    Fused<ExecSE_VX_VY>,
+    Fused<ExecLD_I_VX_VY>,
+    Fused<ExecLD_VX_VY_I>,
+    Fused<ExecLD_VX_KK>,
+    Fused<ExecADD_VX_KK>,
+    Fused<ExecLD_VX_VY>,
+    Fused<ExecOR_VX_VY<Quirks>>,
+    Fused<ExecAND_VX_VY<Quirks>>,
+    Fused<ExecXOR_VX_VY<Quirks>>,
+    Fused<ExecADD_VX_VY>,
+    Fused<ExecSUB_VX_VY>,
+    Fused<ExecSHR_VX<Quirks>>,
+    Fused<ExecSUBN_VX_VY>,
+    Fused<ExecSHL_VX<Quirks>>,
+    Fused<ExecSNE_VX_VY>,
+    Fused<ExecLD_I>,
+    Fused<ExecJP_V0<Quirks>>,
+    Fused<ExecRND_VX_KK>,
+    Fused<ExecDRW_VX_VY<Quirks>>,
+    Fused<ExecSKP_VX>,
+    Fused<ExecSKNP_VX>,
+    Fused<ExecLD_I_LONG>,
+    Fused<ExecPLANE>,
+    Fused<ExecLD_VX_DT>,
+    Fused<ExecLD_VX_K>,
+    Fused<ExecLD_DT_VX>,
+    Fused<ExecLD_ST_VX>,
+    Fused<ExecADD_I_VX>,
+    Fused<ExecLD_F_VX>,
+    Fused<ExecLD_HF_VX>,
+    Fused<ExecLD_B_VX<Quirks>>,
+    Fused<ExecLD_I_VX<Quirks>>,
+    Fused<ExecLD_VX_I<Quirks>>,
+    Fused<ExecLD_R_VX>,
+    Fused<ExecLD_VX_R>,
+    Fused<ExecUNKNOWN>,
+};
+
+struct Fusion {
+  std::array<Opcode, SUPEROP_MAX_LENGTH> opcodes;
+  uint8_t length;
+  SuperOpFn fn;
+};
+
+/*
+ * The fusion set, picked from the dynamic instruction pair and triple
+ * frequencies measured over 20000 frames of each ROM in roms/ (percentages
+ * of all executed instructions). Jumps to self, which are 28% of all pairs,
+ * are left to the plain loop. Longer sequences are matched first.
+ */
+constexpr Fusion F(Opcode a, Opcode b, SuperOpFn fn) {
+  return Fusion{{a, b, Opcode::UNKNOWN}, 2, fn};
+}
+constexpr Fusion F(Opcode a, Opcode b, Opcode c, SuperOpFn fn) {
+  return Fusion{{a, b, c}, 3, fn};
+}
+
+template <typename Quirks>
+const std::array<Fusion, 17> FUSIONS = {{
+    /* Waiting on the delay timer, 2.4% */
+    F(Opcode::LD_VX_DT, Opcode::SE_VX_KK, Opcode::JP,
+      Fused<ExecLD_VX_DT, ExecSE_VX_KK, ExecJP>),
+    F(Opcode::LD_VX_DT, Opcode::SNE_VX_KK, Opcode::JP,
+      Fused<ExecLD_VX_DT, ExecSNE_VX_KK, ExecJP>),
+    /* Drawing the next digit, 1.4% */
+    F(Opcode::ADD_VX_KK, Opcode::LD_F_VX, Opcode::DRW_VX_VY,
+      Fused<ExecADD_VX_KK, ExecLD_F_VX, ExecDRW_VX_VY<Quirks>>),
+    /* Counted loops, 1.4% */
+    F(Opcode::ADD_VX_KK, Opcode::SE_VX_KK, Opcode::JP,
+      Fused<ExecADD_VX_KK, ExecSE_VX_KK, ExecJP>),
+    F(Opcode::ADD_VX_KK, Opcode::SNE_VX_KK, Opcode::JP,
+      Fused<ExecADD_VX_KK, ExecSNE_VX_KK, ExecJP>),
+    /* Conditional jumps, 5.5% */
+    F(Opcode::SE_VX_KK, Opcode::JP, Fused<ExecSE_VX_KK, ExecJP>),
+    F(Opcode::SNE_VX_KK, Opcode::JP, Fused<ExecSNE_VX_KK, ExecJP>),
+    /* Moving after drawing, 3.1% */
+    F(Opcode::DRW_VX_VY, Opcode::ADD_VX_KK,
+      Fused<ExecDRW_VX_VY<Quirks>, ExecADD_VX_KK>),
+    /* Chained comparisons, 2.7% and 2.5% */
+    F(Opcode::SNE_VX_KK, Opcode::SNE_VX_KK,
+      Fused<ExecSNE_VX_KK, ExecSNE_VX_KK>),
+    F(Opcode::SKNP_VX, Opcode::SKNP_VX, Fused<ExecSKNP_VX, ExecSKNP_VX>),
+    /* Sprite setup, 2.2% */
+    F(Opcode::LD_F_VX, Opcode::DRW_VX_VY,
+      Fused<ExecLD_F_VX, ExecDRW_VX_VY<Quirks>>),
+    F(Opcode::LD_I, Opcode::DRW_VX_VY,
+      Fused<ExecLD_I, ExecDRW_VX_VY<Quirks>>),
+    /* Polling a key, 1.9% */
+    F(Opcode::LD_VX_KK, Opcode::SKNP_VX, Fused<ExecLD_VX_KK, ExecSKNP_VX>),
+    F(Opcode::LD_VX_KK, Opcode::SKP_VX, Fused<ExecLD_VX_KK, ExecSKP_VX>),
+    /* Masking, 1.9% */
+    F(Opcode::LD_VX_KK, Opcode::AND_VX_VY,
+      Fused<ExecLD_VX_KK, ExecAND_VX_VY<Quirks>>),
+    /* Table lookups, 1.4% and 1.2% */
+    F(Opcode::LD_I, Opcode::ADD_I_VX, Fused<ExecLD_I, ExecADD_I_VX>),
+    F(Opcode::LD_I, Opcode::LD_VX_I,
+      Fused<ExecLD_I, ExecLD_VX_I<Quirks>>),
+}};
+
+/* Instructions after which execution may not continue at the next address,
+ * or that may have overwritten code
+ */
+bool EndsTrace(const Opcode opcode) {
+  switch (opcode) {
+    case Opcode::RET:
+    case Opcode::JP:
+    case Opcode::CALL:
+    case Opcode::SE_VX_KK:
+    case Opcode::SNE_VX_KK:
+    case Opcode::SE_VX_VY:
+    case Opcode::SNE_VX_VY:
+    case Opcode::JP_V0:
+    case Opcode::SKP_VX:
+    case Opcode::SKNP_VX:
+    case Opcode::EXIT:
+    case Opcode::LD_I_LONG:
+    case Opcode::LD_VX_K:
+    case Opcode::LD_B_VX:
+    case Opcode::LD_I_VX:
+    case Opcode::LD_I_VX_VY:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Matches(Memory &memory, const uint16_t address, const Fusion &fusion) {
+  for (auto i = 0; i < fusion.length; ++i) {
+    const uint16_t at = address + (i * 2);
+    if (at >= RAM_SIZE - 1) return false;
+    if (memory.Decode(at).opcode != fusion.opcodes.at(i)) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+void Superblocks::Flush() {
+  for (auto &block : m_blocks) block.reset();
+}
+
+Superblocks::Superblocks(const Quirks quirks) {
+  m_form = WithQuirks(quirks, [](auto profile) {
+    return &Superblocks::Form<decltype(profile)>;
+  });
+}
+
+template <typename Quirks>
+std::unique_ptr<Superblock> Superblocks::Form(Memory &memory,
+                                              const uint16_t pc) {
+  auto block = std::make_unique<Superblock>();
+  block->address = pc;
+  uint16_t address = pc;
+  bool ends = false;
+
+  while (!ends && block->length < SUPERBLOCK_MAX_LENGTH &&
+         address < RAM_SIZE - 1) {
+    SuperOp op{};
+    op.address = address;
+    for (const auto &fusion : FUSIONS<Quirks>) {
+      if (Matches(memory, address, fusion)) {
+        op.fn = fusion.fn;
+        op.length = fusion.length;
+        break;
+      }
+    }
+    if (op.fn == nullptr) {
+      const auto opcode = memory.Decode(address).opcode;
+      op.fn = SINGLES<Quirks>.at(static_cast<size_t>(opcode));
+      op.length = 1;
+    }
+    for (auto i = 0; i < op.length; ++i) {
+      const auto &decoded = memory.Decode(address);
+      op.instructions.at(i) = decoded.instruction;
+      ends = ends || EndsTrace(decoded.opcode);
+      address += 2;
+    }
+    block->length += op.length;
+    block->ops.push_back(op);
+  }
+  return block;
+}
+
+Superblock *Superblocks::Lookup(Memory &memory, const uint16_t pc) {
+  if (pc >= RAM_SIZE - 1) return nullptr;
+  auto &block = m_blocks.at(pc);
+  if (block == nullptr) block = (this->*m_form)(memory, pc);
+  return block.get();
+}
+
+Superblock *Superblocks::Next(Memory &memory, Superblock *from,
+                              const uint16_t pc) {
+  if (pc == from->address) return from;
+  for (const auto &link : from->links) {
+    if (link.block != nullptr && link.pc == pc) return link.block;
+  }
+  auto *to = Lookup(memory, pc);
+  if (to != nullptr) {
+    from->links.at(from->next_link) = {pc, to};
+    from->next_link = (from->next_link + 1) % from->links.size();
+  }
+  return to;
+}
+
+int Superblocks::Run(Machine &machine, int ticks) {
+  auto &memory = machine.memory;
+  const auto &pc = machine.cpu.pc;
+  Superblock *block = nullptr;
+
+  while (ticks > 0 && !machine.cpu.Stopped()) {
+    if (m_generation != memory.CodeGeneration()) {
+      Flush();
+      m_generation = memory.CodeGeneration();
+      block = nullptr;
+    }
+    block = block == nullptr ? Lookup(memory, pc) : Next(memory, block, pc);
+    if (block == nullptr) {
+      machine.Tick();
+      --ticks;
+      continue;
+    }
+    /* A fault leaves pc at the faulting instruction, so the rest of the
+     * trace must not run
+     */
+    if (block->length <= ticks) {
+      for (const auto &op : block->ops) {
+        ticks -= op.fn(machine, op);
+        if (machine.cpu.Faulted()) return ticks;
+      }
+      continue;
+    }
+    /* The trace does not fit in what is left of the budget, so run whole
+     * ops for as long as they fit and single-step the rest.
+     */
+    for (const auto &op : block->ops) {
+      if (op.length > ticks || machine.cpu.Faulted()) break;
+      ticks -= op.fn(machine, op);
+    }
+    for (; ticks > 0 && !machine.cpu.Stopped(); --ticks) machine.Tick();
+  }
+  return ticks;
+}
+
+}  // namespace cchip8
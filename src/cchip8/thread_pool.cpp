@@ -0,0 +1,146 @@
+#include <cchip8/thread_pool.h>
+
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cchip8 {
+
+namespace {
+
+/* The CPUs this process may run on, in order, or none if unknown */
+std::vector<int> AllowedCores() {
+  std::vector<int> cores;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) cores.push_back(cpu);
+    }
+  }
+#endif
+  return cores;
+}
+
+/* Pins a worker to one of the allowed CPUs. Returns false if it could not */
+bool PinToCore(std::thread& thread, int core) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  int error = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+  if (error != 0) {
+    std::cerr << "Could not pin worker to CPU " << core << ": "
+              << std::strerror(error) << std::endl;
+    return false;
+  }
+  return true;
+#else
+  (void)thread;
+  (void)core;
+  return false;
+#endif
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads, bool pin) {
+  if (threads == 0) threads = 1;
+  for (size_t i = 0; i < threads; ++i) {
+    m_queues.push_back(std::make_unique<Queue>());
+  }
+  /* Worker i goes to the i-th CPU the process is allowed on, which need not
+   * be CPU i under taskset or a cgroup. Pinning stops at the first failure
+   * and the remaining workers are left to the scheduler.
+   */
+  auto cores = pin ? AllowedCores() : std::vector<int>{};
+  for (size_t i = 0; i < threads; ++i) {
+    m_workers.emplace_back(&ThreadPool::Work, this, i);
+    if (cores.empty()) continue;
+    if (!PinToCore(m_workers.back(), cores[i % cores.size()])) cores.clear();
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_work_available.notify_all();
+  for (auto& worker : m_workers) worker.join();
+}
+
+void ThreadPool::Submit(Job job) {
+  auto& queue = *m_queues.at(m_next++ % m_queues.size());
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_queued;
+    ++m_pending;
+  }
+  m_work_available.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_all_done.wait(lock, [this] { return m_pending == 0; });
+}
+
+bool ThreadPool::Pop(size_t index, Job& job) {
+  auto& queue = *m_queues.at(index);
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.jobs.empty()) return false;
+  job = std::move(queue.jobs.back());
+  queue.jobs.pop_back();
+  return true;
+}
+
+bool ThreadPool::Steal(size_t index, Job& job) {
+  for (size_t offset = 1; offset < m_queues.size(); ++offset) {
+    auto& queue = *m_queues.at((index + offset) % m_queues.size());
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) continue;
+    job = std::move(queue.jobs.front());
+    queue.jobs.pop_front();
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::Work(size_t index) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_work_available.wait(lock,
+                            [this] { return m_stopping || m_queued > 0; });
+      if (m_queued == 0) return;
+      --m_queued;
+    }
+    /* Jobs are pushed before they are counted as queued, so one of the
+     * queues is guaranteed to hold the job just claimed.
+     */
+    Job job;
+    while (!Pop(index, job) && !Steal(index, job)) {
+      std::this_thread::yield();
+    }
+    job();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (--m_pending == 0) m_all_done.notify_all();
+    }
+  }
+}
+
+}  // namespace cchip8
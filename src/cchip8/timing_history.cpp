@@ -0,0 +1,30 @@
+#include <cchip8/timing_history.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace cchip8 {
+
+void TimingHistory::Record(const uint64_t nanoseconds) {
+  if (m_samples.size() < m_capacity) {
+    m_samples.push_back(nanoseconds);
+  } else {
+    m_samples[m_next] = nanoseconds;
+  }
+  m_next = (m_next + 1) % m_capacity;
+}
+
+double TimingHistory::Percentile(const double p) const {
+  if (m_samples.empty()) return 0.0;
+  auto sorted = m_samples;
+  const auto rank = static_cast<size_t>(
+      std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+  const auto nth =
+      sorted.begin() + (std::clamp<size_t>(rank, 1, sorted.size()) - 1);
+  std::nth_element(sorted.begin(), nth, sorted.end());
+  return static_cast<double>(*nth) / 1e6;
+}
+
+}  // namespace cchip8
@@ -6,14 +6,19 @@ namespace cchip8 {
 
 bool Window::Init() {
   SDL_CreateWindowAndRenderer(WINDOW_WIDTH * WINDOW_SCALE,
-                              WINDOW_HEIGHT * WINDOW_SCALE, 0, &m_window,
-                              &m_renderer);
+                              WINDOW_HEIGHT * WINDOW_SCALE,
+                              SDL_WINDOW_RESIZABLE, &m_window, &m_renderer);
   if (m_window == nullptr || m_renderer == nullptr) {
     SDL_Log("Unable to initialize SDL: %s", SDL_GetError());
     return false;
   }
   SDL_SetWindowTitle(m_window, WINDOW_TITLE);
-  m_display.Init(0, 0, m_renderer);
+  SDL_SetWindowMinimumSize(m_window, WINDOW_WIDTH, WINDOW_HEIGHT);
+  /* Presenting waits for the display's refresh, which only ever holds up
+   * this thread and not the emulation
+   */
+  SDL_SetRenderVSync(m_renderer, 1);
+  if (!m_display.Init(m_renderer)) return false;
   m_menu.Init(0, 0, m_renderer);
   running = true;
   return running;
@@ -24,25 +29,26 @@ void Window::Clear() {
   SDL_RenderClear(m_renderer);
 }
 
-void Window::DrawDisplay(const Memory &memory) {
-  for (auto y = 0; y < DISPLAY_HEIGHT; ++y) {
-    for (auto x = 0; x < DISPLAY_WIDTH; ++x) {
-      if (memory.vram.at(x + (y * DISPLAY_WIDTH))) {
-        m_display.DrawPixel(x, y);
-      }
-    }
-  }
+void Window::Update(const Framebuffer &vram, const uint64_t rows) {
+  m_display.Update(vram, rows);
 }
 
-void Window::Draw(const Memory &memory) {
+void Window::DrawDisplay() {
+  SDL_GetRenderOutputSize(m_renderer, &m_width, &m_height);
+  m_display.Draw(m_width, m_height);
+  stale = false;
+}
+
+void Window::Draw() {
   Clear();
-  DrawDisplay(memory);
+  DrawDisplay();
   Render();
 }
 
-void Window::DrawMenu(const Memory &memory) {
+void Window::DrawMenu() {
   Clear();
-  DrawDisplay(memory);
+  DrawDisplay();
+  m_menu.Place(m_width, m_height);
   m_menu.Display();
   Render();
 }
@@ -52,6 +58,10 @@ void Window::HandleEvent(const SDL_Event &event) {
     case SDL_EVENT_QUIT:
       running = false;
       break;
+    case SDL_EVENT_WINDOW_EXPOSED:
+    case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+      stale = true;
+      break;
   }
 }
 
@@ -76,6 +86,7 @@ void Window::Render() { SDL_RenderPresent(m_renderer); }
 
 void Window::Quit() {
   m_menu.Quit();
+  m_display.Quit();
   if (m_renderer != nullptr) SDL_DestroyRenderer(m_renderer);
   if (m_window != nullptr) SDL_DestroyWindow(m_window);
   SDL_QuitSubSystem(SDL_INIT_VIDEO);
@@ -1,11 +1,91 @@
+#include <cchip8/audio.h>
 #include <cchip8/emulator.h>
+#include <cchip8/machine.h>
 #include <cchip8/memory.h>
+#include <cchip8/movie.h>
+#include <cchip8/quirks.h>
 #include <cchip8/rom.h>
+#include <cchip8/scheduler.h>
 
+#include <cctype>
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
 #include <string>
 
-void usage() { std::cout << "Usage: cchip8 rom.ch8" << std::endl; }
+void usage() {
+  std::cout << "Usage: cchip8 [options] rom.ch8\n"
+            << "Options:\n"
+            << "  --superblock   Run fused instruction traces\n"
+            << "  --jit          Run translated x86-64 code where possible\n"
+            << "  --jit-compare  Check every translated block against the "
+               "interpreter\n"
+            << "  --seed N       Seed RND with N for a reproducible run\n"
+            << "  --no-idle-skip Always interpret idle loops, never skip them\n"
+            << "  --quirks NAME  Behave like chip8 (COSMAC VIP), schip\n"
+            << "                 (SUPER-CHIP 1.1) or modern (default)\n"
+            << "  --ipf N        Run N instructions per 60 Hz frame, from 1 "
+               "to 65536\n"
+            << "                 (default 10)\n"
+            << "  --turbo        Run as fast as possible, drawing every 10th "
+               "frame\n"
+            << "  --autosave     Save to rom.ch8.autosave every frame and "
+               "resume from it\n"
+            << "  --record FILE  Record the keypad of every frame to a movie\n"
+            << "  --play FILE    Drive the keypad from a recorded movie\n"
+            << "  --headless     With --play, replay without a window as fast "
+               "as possible\n"
+            << "                 and print a hash of the frames\n"
+            << "  --catch-up N   Run at most N late frames back to back "
+               "(default 4)\n"
+            << "  --audio-buffer N\n"
+            << "                 Ask for an audio buffer of N sample frames, "
+               "from 32 to\n"
+            << "                 8192, smaller for lower latency\n"
+            << "  -h, --help     Show this message\n"
+            << "While running, Escape pauses, = and - double and halve the "
+               "instructions\n"
+            << "per frame, Tab toggles turbo and holding Backspace rewinds. "
+               "F1 to F8\n"
+            << "load a save state slot and Shift+F1 to F8 save one."
+            << std::endl;
+}
+
+/* Reads a decimal, 0x hex or 0 octal number from the whole of `text`,
+ * failing on anything else or on a value outside min to max
+ */
+bool ParseNumber(const std::string& text, uint64_t& value,
+                 const uint64_t min = 0, const uint64_t max = UINT64_MAX) {
+  /* stoull would skip spaces and take a sign, wrapping negative numbers */
+  if (text.empty() || std::isdigit(static_cast<unsigned char>(text[0])) == 0) {
+    return false;
+  }
+  try {
+    size_t used = 0;
+    value = std::stoull(text, &used, 0);
+    return used == text.size() && value >= min && value <= max;
+  } catch (const std::logic_error&) {
+    return false;
+  }
+}
+
+/* Replays a movie on a bare Machine, with no SDL at all */
+int PlayHeadless(const cchip8::Rom& rom, const std::string& filename,
+                 const cchip8::Backend backend) {
+  cchip8::Movie movie;
+  cchip8::PlaybackResult result;
+  if (!movie.Load(filename) || !movie.Play(rom, backend, result)) {
+    return EXIT_FAILURE;
+  }
+  const auto emulated = static_cast<double>(result.frames) / FRAME_RATE;
+  std::cout << "Played " << result.frames << " frames in " << result.seconds
+            << " s, " << emulated / result.seconds << "x real time\n"
+            << "Hash " << std::hex << std::setw(16) << std::setfill('0')
+            << result.hash << std::endl;
+  return EXIT_SUCCESS;
+}
 
 int main(int argc, char** argv) {
   if (argc < 2) {
@@ -14,11 +94,69 @@ int main(int argc, char** argv) {
   }
 
   std::string file{};
+  auto backend = cchip8::Backend::Interpreter;
+  std::optional<uint64_t> seed{};
+  auto idle_skip = true;
+  auto quirks = cchip8::Quirks::Modern;
+  auto catch_up = SCHEDULER_MAX_CATCH_UP;
+  auto ipf = TICKS_PER_FRAME;
+  auto turbo = false;
+  auto autosave = false;
+  std::string record{};
+  std::string play{};
+  auto headless = false;
+  auto audio_buffer = 0;
   for (int i = 1; i < argc; ++i) {
     std::string arg = argv[i];
+    uint64_t value = 0;
+    auto invalid = [&] {
+      std::cerr << "Invalid value for " << arg << ": " << argv[i] << std::endl;
+      return EXIT_FAILURE;
+    };
     if (arg == "--help" || arg == "-h") {
       usage();
       return EXIT_SUCCESS;
+    } else if (arg == "--superblock") {
+      backend = cchip8::Backend::Superblock;
+    } else if (arg == "--jit") {
+      backend = cchip8::Backend::Jit;
+    } else if (arg == "--jit-compare") {
+      backend = cchip8::Backend::JitCompare;
+    } else if (arg == "--seed" && i + 1 < argc) {
+      if (!ParseNumber(argv[++i], value)) return invalid();
+      seed = value;
+    } else if (arg == "--no-idle-skip") {
+      idle_skip = false;
+    } else if (arg == "--quirks" && i + 1 < argc) {
+      if (!cchip8::ParseQuirks(argv[++i], quirks)) {
+        std::cerr << "Unknown quirks profile: " << argv[i] << std::endl;
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--ipf" && i + 1 < argc) {
+      if (!ParseNumber(argv[++i], value, MIN_TICKS_PER_FRAME,
+                       MAX_TICKS_PER_FRAME)) {
+        return invalid();
+      }
+      ipf = static_cast<int>(value);
+    } else if (arg == "--turbo") {
+      turbo = true;
+    } else if (arg == "--autosave") {
+      autosave = true;
+    } else if (arg == "--record" && i + 1 < argc) {
+      record = argv[++i];
+    } else if (arg == "--play" && i + 1 < argc) {
+      play = argv[++i];
+    } else if (arg == "--headless") {
+      headless = true;
+    } else if (arg == "--catch-up" && i + 1 < argc) {
+      if (!ParseNumber(argv[++i], value, 1, INT32_MAX)) return invalid();
+      catch_up = static_cast<int>(value);
+    } else if (arg == "--audio-buffer" && i + 1 < argc) {
+      if (!ParseNumber(argv[++i], value, AUDIO_MIN_DEVICE_FRAMES,
+                       AUDIO_MAX_DEVICE_FRAMES)) {
+        return invalid();
+      }
+      audio_buffer = static_cast<int>(value);
     } else if (file.empty()) {
       file = arg;
     }
@@ -29,7 +167,28 @@ int main(int argc, char** argv) {
     return EXIT_FAILURE;
   }
 
+  if (headless) {
+    if (play.empty()) {
+      std::cerr << "--headless needs a movie to --play" << std::endl;
+      return EXIT_FAILURE;
+    }
+    return PlayHeadless(rom, play, backend);
+  }
+
   cchip8::Emulator emulator;
+  if (!emulator.SetBackend(backend)) {
+    return EXIT_FAILURE;
+  }
+  if (seed) emulator.SetSeed(*seed);
+  emulator.SetIdleSkip(idle_skip);
+  emulator.SetQuirks(quirks);
+  emulator.SetMaxCatchUp(catch_up);
+  emulator.SetTicksPerFrame(ipf);
+  emulator.SetTurbo(turbo);
+  emulator.SetAutosave(autosave);
+  if (audio_buffer > 0) emulator.SetAudioBuffer(audio_buffer);
+  if (!record.empty()) emulator.Record(record);
+  if (!play.empty() && !emulator.Play(play)) return EXIT_FAILURE;
   if (emulator.LoadRom(rom)) {
     emulator.Start();
   } else {
@@ -0,0 +1,56 @@
+#include <cchip8/jit.h>
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+constexpr int FRAMES = 1200;
+constexpr int TICKS = 50;
+
+/* Runs a program on the interpreter and on `backend` side by side with the
+ * same keys, comparing the whole machine state after every frame
+ */
+void ExpectSameAsInterpreter(const Backend backend, const Rom& rom,
+                             const Quirks quirks) {
+  Machine reference;
+  Machine machine;
+  for (auto* m : {&reference, &machine}) {
+    m->SetQuirks(quirks);
+    ASSERT_TRUE(m->Load(rom));
+  }
+  ASSERT_TRUE(machine.SetBackend(backend));
+  for (auto frame = 0; frame < FRAMES; ++frame) {
+    reference.input.SetKeys(ScriptedKeys(frame));
+    machine.input.SetKeys(ScriptedKeys(frame));
+    reference.RunFrame(TICKS);
+    machine.RunFrame(TICKS);
+    ASSERT_EQ(State(reference), State(machine)) << "after frame " << frame;
+  }
+}
+
+void ExpectAllSameAsInterpreter(const Backend backend) {
+  for (const auto* name : BUNDLED_ROMS) {
+    const auto rom = BundledRom(name);
+    for (const auto quirks : ALL_QUIRKS) {
+      SCOPED_TRACE(std::string(name) + " under " + QuirksName(quirks));
+      ExpectSameAsInterpreter(backend, rom, quirks);
+    }
+  }
+}
+
+TEST(BackendTest, SuperblocksMatchInterpreter) {
+  ExpectAllSameAsInterpreter(Backend::Superblock);
+}
+
+TEST(BackendTest, JitMatchesInterpreter) {
+  if (!Jit::Supported()) GTEST_SKIP() << "The JIT is not built for this host";
+  ExpectAllSameAsInterpreter(Backend::Jit);
+}
+
+}  // namespace
+}  // namespace cchip8::test
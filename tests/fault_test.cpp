@@ -0,0 +1,88 @@
+#include <cchip8/cpu.h>
+#include <cchip8/jit.h>
+#include <cchip8/lockstep.h>
+#include <cchip8/machine.h>
+#include <cchip8/memory.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+constexpr int FRAMES = 10;
+constexpr int TICKS = 50;
+
+struct ExpectedFault {
+  const char* rom;
+  FaultKind kind;
+  uint16_t pc;
+  uint16_t address;
+};
+
+/* 00EE with nothing on the stack, and a subroutine that calls itself until
+ * the stack is full. Both fault on the program's first instruction.
+ */
+const std::vector<ExpectedFault> STACK_FAULTS = {
+    {"ret_underflow.ch8", FaultKind::StackUnderflow, PROGRAM_START, 0},
+    {"call_overflow.ch8", FaultKind::StackOverflow, PROGRAM_START,
+     STACK_SIZE},
+};
+
+/* With the checked memory policy the CPU stops on the fault. The fast
+ * policy wraps the stack pointer instead, which must not fault or crash.
+ */
+void ExpectFault(const Cpu& cpu, const ExpectedFault& expected) {
+  if constexpr (MemoryPolicy::checked) {
+    ASSERT_TRUE(cpu.Faulted());
+    EXPECT_EQ(cpu.fault.kind, expected.kind);
+    EXPECT_EQ(cpu.fault.pc, expected.pc);
+    EXPECT_EQ(cpu.fault.address, expected.address);
+    EXPECT_EQ(cpu.pc, expected.pc);
+  } else {
+    EXPECT_FALSE(cpu.Faulted());
+  }
+}
+
+void ExpectStackFaults(const Backend backend) {
+  for (const auto& expected : STACK_FAULTS) {
+    SCOPED_TRACE(expected.rom);
+    Machine machine;
+    ASSERT_TRUE(machine.Load(LoadRom(CCHIP8_TEST_ROM_DIR, expected.rom)));
+    ASSERT_TRUE(machine.SetBackend(backend));
+    for (auto frame = 0; frame < FRAMES; ++frame) machine.RunFrame(TICKS);
+    ExpectFault(machine.cpu, expected);
+  }
+}
+
+TEST(FaultTest, InterpreterStackFaults) {
+  ExpectStackFaults(Backend::Interpreter);
+}
+
+TEST(FaultTest, SuperblockStackFaults) {
+  ExpectStackFaults(Backend::Superblock);
+}
+
+TEST(FaultTest, JitStackFaults) {
+  if (!Jit::Supported()) GTEST_SKIP() << "The JIT is not built for this host";
+  ExpectStackFaults(Backend::Jit);
+}
+
+TEST(FaultTest, LockstepStackFaults) {
+  for (const auto& expected : STACK_FAULTS) {
+    SCOPED_TRACE(expected.rom);
+    Lockstep lockstep(LoadRom(CCHIP8_TEST_ROM_DIR, expected.rom), 4);
+    for (auto frame = 0; frame < FRAMES; ++frame) lockstep.RunFrame(TICKS);
+    for (size_t lane = 0; lane < lockstep.Lanes(); ++lane) {
+      ExpectFault(lockstep.LaneCpu(lane), expected);
+      EXPECT_EQ(lockstep.Faulted(lane), MemoryPolicy::checked);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace cchip8::test
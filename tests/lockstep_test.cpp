@@ -0,0 +1,108 @@
+#include <cchip8/lockstep.h>
+#include <cchip8/machine.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+constexpr size_t LANES = 16;
+constexpr int FRAMES = 600;
+constexpr int TICKS = 48;
+
+/* Each lane presses the scripted keys a few frames after the one before,
+ * so that lanes diverge
+ */
+uint16_t LaneKeys(const size_t lane, const int frame) {
+  return ScriptedKeys(frame + static_cast<int>(5 * lane));
+}
+
+/* Runs a program as LANES lockstep lanes and as one scalar Machine per lane
+ * with the same seed and keys, comparing every lane after every frame
+ */
+void ExpectLanesMatchMachines(const Rom& rom, const Quirks quirks) {
+  Lockstep lockstep(rom, LANES, quirks);
+  std::vector<std::unique_ptr<Machine>> machines;
+  for (size_t lane = 0; lane < LANES; ++lane) {
+    machines.push_back(std::make_unique<Machine>());
+    auto& machine = *machines.back();
+    machine.SetQuirks(quirks);
+    ASSERT_TRUE(machine.Load(rom));
+    machine.cpu.Seed(lane + 1);
+    lockstep.Seed(lane, lane + 1);
+  }
+  for (auto frame = 0; frame < FRAMES; ++frame) {
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      lockstep.SetKeypad(lane, LaneKeys(lane, frame));
+      machines[lane]->input.SetKeys(LaneKeys(lane, frame));
+      machines[lane]->RunFrame(TICKS);
+    }
+    lockstep.RunFrame(TICKS);
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      const auto& machine = *machines[lane];
+      const auto cpu = lockstep.LaneCpu(lane);
+      const auto& memory = lockstep.LaneMemory(lane);
+      SCOPED_TRACE(testing::Message()
+                   << "lane " << lane << " after frame " << frame);
+      ASSERT_TRUE(cpu.SameState(machine.cpu)) << "pc " << cpu.pc << " vs "
+                                              << machine.cpu.pc;
+      ASSERT_EQ(lockstep.Faulted(lane), machine.cpu.Faulted());
+      ASSERT_EQ(cpu.fault.kind, machine.cpu.fault.kind);
+      ASSERT_EQ(cpu.fault.pc, machine.cpu.fault.pc);
+      ASSERT_EQ(lockstep.Stopped(lane), machine.cpu.Stopped() &&
+                                            !machine.cpu.halted);
+      /* Lanes never skip idle loops, so they also run what it skipped */
+      ASSERT_EQ(lockstep.Executed(lane),
+                machine.stats.Executed() + machine.stats.skipped);
+      ASSERT_EQ(memory.ram, machine.memory.ram);
+      ASSERT_EQ(memory.FrameHash(), machine.memory.FrameHash());
+    }
+  }
+}
+
+TEST(LockstepTest, LanesMatchScalarMachines) {
+  for (const auto* name : BUNDLED_ROMS) {
+    const auto rom = BundledRom(name);
+    for (const auto quirks : ALL_QUIRKS) {
+      SCOPED_TRACE(std::string(name) + " under " + QuirksName(quirks));
+      ExpectLanesMatchMachines(rom, quirks);
+    }
+  }
+}
+
+/* Lanes that take a random branch into a read past the end of RAM fault
+ * there, with the checked memory policy, while the others carry on
+ */
+TEST(LockstepTest, FaultedLanesStop) {
+  const auto rom = LoadRom(CCHIP8_TEST_ROM_DIR, "lane_fault.ch8");
+  ExpectLanesMatchMachines(rom, Quirks::Modern);
+
+  Lockstep lockstep(rom, LANES);
+  for (size_t lane = 0; lane < LANES; ++lane) lockstep.Seed(lane, lane + 1);
+  lockstep.RunFrame(TICKS);
+  size_t faulted = 0;
+  for (size_t lane = 0; lane < LANES; ++lane) {
+    if (!lockstep.Faulted(lane)) continue;
+    ++faulted;
+    EXPECT_EQ(lockstep.LaneCpu(lane).fault.kind, FaultKind::Ram);
+    EXPECT_EQ(lockstep.LaneCpu(lane).pc, PROGRAM_START + 12);
+  }
+  if constexpr (MemoryPolicy::checked) {
+    EXPECT_GT(faulted, 0u);
+    EXPECT_LT(faulted, LANES);
+  } else {
+    EXPECT_EQ(faulted, 0u);
+  }
+}
+
+}  // namespace
+}  // namespace cchip8::test
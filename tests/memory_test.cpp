@@ -0,0 +1,50 @@
+#include <cchip8/cpu.h>
+#include <cchip8/instruction.h>
+#include <cchip8/memory.h>
+#include <cchip8/quirks.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+
+namespace cchip8::test {
+namespace {
+
+/* Stores V0 and V1 with Fx55 at the last byte of a 4 KiB address space */
+template <typename Quirks>
+void StoreAtEndOfFourKiB(Cpu& cpu, Memory& memory) {
+  cpu.I = 0x0FFF;
+  cpu.registers[0] = 0xAA;
+  cpu.registers[1] = 0xBB;
+  cpu.LD_I_VX<Quirks>(Instruction(0xF155), memory);
+}
+
+/* CHIP-8 and SUPER-CHIP programs see 4 KiB, so a store past its end
+ * wraps to address 0, or faults with checked memory
+ */
+TEST(MemoryTest, FourKiBProfilesWrapAtTheirAddressSpace) {
+  Cpu cpu;
+  auto memory = std::make_unique<Memory>();
+  StoreAtEndOfFourKiB<Chip8Quirks>(cpu, *memory);
+  if constexpr (MemoryPolicy::checked) {
+    EXPECT_EQ(cpu.fault.kind, FaultKind::Ram);
+    EXPECT_EQ(memory->ram[0x0FFF], 0);
+  } else {
+    EXPECT_FALSE(cpu.Faulted());
+    EXPECT_EQ(memory->ram[0x0FFF], 0xAA);
+    EXPECT_EQ(memory->ram[0x0000], 0xBB);
+    EXPECT_EQ(memory->ram[0x1000], 0);
+  }
+}
+
+/* XO-CHIP, run as Modern, goes on into the rest of its 64 KiB */
+TEST(MemoryTest, ModernProfileAddressesAllOfRam) {
+  Cpu cpu;
+  auto memory = std::make_unique<Memory>();
+  StoreAtEndOfFourKiB<ModernQuirks>(cpu, *memory);
+  EXPECT_FALSE(cpu.Faulted());
+  EXPECT_EQ(memory->ram[0x0FFF], 0xAA);
+  EXPECT_EQ(memory->ram[0x1000], 0xBB);
+}
+
+}  // namespace
+}  // namespace cchip8::test
@@ -0,0 +1,157 @@
+#include <cchip8/machine.h>
+#include <cchip8/movie.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+constexpr int FRAMES = 1200;
+/* Where the first run of keys starts, after the header */
+constexpr size_t MOVIE_HEADER_SIZE = 4 + 2 + 1 + 1 + 4 + 8 + 8;
+constexpr size_t TICKS_OFFSET = 4 + 2 + 1 + 1;
+
+Movie ScriptedMovie(const Rom& rom) {
+  Movie movie;
+  movie.seed = 1234;
+  movie.rom_hash = rom.Hash();
+  movie.quirks = Quirks::SuperChip;
+  movie.ticks_per_frame = 30;
+  for (auto frame = 0; frame < FRAMES; ++frame) {
+    movie.Record(ScriptedKeys(frame));
+  }
+  return movie;
+}
+
+std::string TempFile(const char* name) { return testing::TempDir() + name; }
+
+std::vector<uint8_t> ReadFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file), {}};
+}
+
+void WriteFile(const std::string& filename, const std::vector<uint8_t>& data) {
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+/* A movie saved, loaded back and played gives the same frames as the run it
+ * was recorded from, on every backend
+ */
+TEST(MovieTest, ReplayIsBitExact) {
+  for (const auto* name : BUNDLED_ROMS) {
+    SCOPED_TRACE(name);
+    const auto rom = BundledRom(name);
+    const auto recorded = ScriptedMovie(rom);
+    const auto filename = TempFile("cchip8_movie_test.c8m");
+    ASSERT_TRUE(recorded.Save(filename));
+    Movie movie;
+    ASSERT_TRUE(movie.Load(filename));
+    std::remove(filename.c_str());
+    EXPECT_EQ(movie.seed, recorded.seed);
+    EXPECT_EQ(movie.quirks, recorded.quirks);
+    EXPECT_EQ(movie.ticks_per_frame, recorded.ticks_per_frame);
+    ASSERT_EQ(movie.Frames(), recorded.Frames());
+    for (size_t frame = 0; frame < movie.Frames(); ++frame) {
+      ASSERT_EQ(movie.Keys(frame), recorded.Keys(frame)) << frame;
+    }
+
+    Machine machine;
+    ASSERT_TRUE(recorded.Prepare(rom, machine));
+    for (size_t frame = 0; frame < recorded.Frames(); ++frame) {
+      machine.input.SetKeys(recorded.Keys(frame));
+      machine.RunFrame(recorded.ticks_per_frame);
+    }
+
+    PlaybackResult first;
+    ASSERT_TRUE(movie.Play(rom, Backend::Interpreter, first));
+    EXPECT_EQ(first.frames, recorded.Frames());
+    for (const auto backend : {Backend::Interpreter, Backend::Superblock}) {
+      PlaybackResult again;
+      ASSERT_TRUE(movie.Play(rom, backend, again));
+      EXPECT_EQ(again.hash, first.hash);
+    }
+
+    /* Play() ends on the state of the recorded run */
+    Machine replayed;
+    ASSERT_TRUE(movie.Prepare(rom, replayed));
+    for (size_t frame = 0; frame < movie.Frames(); ++frame) {
+      replayed.input.SetKeys(movie.Keys(frame));
+      replayed.RunFrame(movie.ticks_per_frame);
+    }
+    EXPECT_EQ(State(replayed), State(machine));
+  }
+}
+
+TEST(MovieTest, RejectsOtherRoms) {
+  const auto movie = ScriptedMovie(BundledRom("brix.ch8"));
+  Machine machine;
+  EXPECT_FALSE(movie.Prepare(BundledRom("pong2.ch8"), machine));
+}
+
+/* Damaged files are refused, without touching the movie or allocating
+ * whatever a corrupt run length asks for
+ */
+TEST(MovieTest, RejectsDamagedFiles) {
+  const auto rom = BundledRom("tetris.ch8");
+  const auto filename = TempFile("cchip8_movie_damaged.c8m");
+  ASSERT_TRUE(ScriptedMovie(rom).Save(filename));
+  const auto good = ReadFile(filename);
+  ASSERT_GT(good.size(), MOVIE_HEADER_SIZE + 3);
+
+  auto with_ticks = [&](const uint32_t ticks) {
+    auto data = good;
+    for (auto byte = 0; byte < 4; ++byte) {
+      data[TICKS_OFFSET + byte] = (ticks >> (8 * byte)) & 0xFF;
+    }
+    return data;
+  };
+  auto with_run = [&](const std::vector<uint8_t>& run) {
+    std::vector<uint8_t> data(good.begin(), good.begin() + MOVIE_HEADER_SIZE);
+    data.push_back(0x01);
+    data.push_back(0x00);
+    data.insert(data.end(), run.begin(), run.end());
+    return data;
+  };
+  const std::vector<std::vector<uint8_t>> damaged = {
+      with_ticks(0),
+      with_ticks(MAX_TICKS_PER_FRAME + 1),
+      with_ticks(UINT32_MAX),
+      /* A run of 2^63 frames */
+      with_run({0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01}),
+      /* A varint that never ends */
+      with_run(std::vector<uint8_t>(11, 0xFF)),
+      with_run({0x00}),
+      /* Cut off in the middle of a run */
+      with_run({}),
+      std::vector<uint8_t>(good.begin(), good.begin() + MOVIE_HEADER_SIZE - 1),
+  };
+
+  Movie movie;
+  movie.ticks_per_frame = 77;
+  movie.Record(0x0F);
+  for (size_t i = 0; i < damaged.size(); ++i) {
+    WriteFile(filename, damaged[i]);
+    EXPECT_FALSE(movie.Load(filename)) << "damaged file " << i;
+    EXPECT_EQ(movie.ticks_per_frame, 77);
+    EXPECT_EQ(movie.Frames(), 1u);
+  }
+
+  WriteFile(filename, with_run({0x05}));
+  ASSERT_TRUE(movie.Load(filename));
+  EXPECT_EQ(movie.Frames(), 5u);
+  std::remove(filename.c_str());
+}
+
+}  // namespace
+}  // namespace cchip8::test
@@ -0,0 +1,88 @@
+#include <cchip8/machine.h>
+#include <cchip8/rewind.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+/* Enough frames to span a few keyframes */
+constexpr int FRAMES = (2 * REWIND_KEYFRAME_INTERVAL) + 100;
+constexpr int TICKS = 50;
+
+/* Runs a program for FRAMES frames, capturing each one, and then steps back
+ * over all of them, expecting every frame's state in reverse order. Going
+ * forward again from the oldest frame must match a machine that loaded it
+ * as a state, so rewinding leaves no stale cache behind.
+ */
+void ExpectRoundTrip(const Rom& rom, const Backend backend) {
+  Machine machine;
+  ASSERT_TRUE(machine.Load(rom));
+  ASSERT_TRUE(machine.SetBackend(backend));
+  Rewind rewind;
+  std::vector<std::vector<uint8_t>> states;
+  for (auto frame = 0; frame < FRAMES; ++frame) {
+    machine.input.SetKeys(ScriptedKeys(frame));
+    machine.RunFrame(TICKS);
+    rewind.Capture(machine);
+    states.push_back(State(machine));
+  }
+  ASSERT_EQ(rewind.Frames(), states.size());
+
+  for (auto frame = FRAMES - 2; frame >= 0; --frame) {
+    ASSERT_TRUE(rewind.StepBack(machine)) << "to frame " << frame;
+    ASSERT_EQ(State(machine), states[frame]) << "at frame " << frame;
+  }
+  EXPECT_FALSE(rewind.StepBack(machine));
+  EXPECT_EQ(State(machine), states.front());
+  EXPECT_EQ(rewind.Frames(), 1u);
+
+  /* The keypad is not part of the state, so the rewound machine starts
+   * over with a fresh one, like a machine that loads the first frame
+   */
+  Machine reference;
+  ASSERT_TRUE(reference.Load(rom));
+  ASSERT_TRUE(reference.SetBackend(backend));
+  reference.LoadState(states.front().data());
+  machine.input.Reset();
+  for (auto frame = 1; frame < FRAMES; ++frame) {
+    for (auto* m : {&machine, &reference}) {
+      m->input.SetKeys(ScriptedKeys(frame));
+      m->RunFrame(TICKS);
+    }
+    rewind.Capture(machine);
+    ASSERT_EQ(State(machine), State(reference)) << "replaying " << frame;
+  }
+}
+
+TEST(RewindTest, StepsBackThroughEveryFrame) {
+  for (const auto* name : BUNDLED_ROMS) {
+    SCOPED_TRACE(name);
+    const auto rom = BundledRom(name);
+    ExpectRoundTrip(rom, Backend::Interpreter);
+    ExpectRoundTrip(rom, Backend::Superblock);
+  }
+}
+
+TEST(RewindTest, ClearForgetsHistory) {
+  Machine machine;
+  ASSERT_TRUE(machine.Load(BundledRom("pong2.ch8")));
+  Rewind rewind;
+  for (auto frame = 0; frame < 10; ++frame) {
+    machine.RunFrame(TICKS);
+    rewind.Capture(machine);
+  }
+  rewind.Clear();
+  EXPECT_EQ(rewind.Frames(), 0u);
+  const auto state = State(machine);
+  EXPECT_FALSE(rewind.StepBack(machine));
+  EXPECT_EQ(State(machine), state);
+}
+
+}  // namespace
+}  // namespace cchip8::test
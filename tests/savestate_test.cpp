@@ -0,0 +1,129 @@
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <cchip8/savestate.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "test_util.h"
+
+namespace cchip8::test {
+namespace {
+
+constexpr int FRAMES = 300;
+constexpr int TICKS = 50;
+
+void RunFrames(Machine& machine, const int first, const int count) {
+  for (auto frame = first; frame < first + count; ++frame) {
+    machine.input.SetKeys(ScriptedKeys(frame));
+    machine.RunFrame(TICKS);
+  }
+}
+
+/* Saves part way through a run, loads the record into a machine running
+ * under another profile, and expects both to carry on identically
+ */
+TEST(SaveStateTest, RecordRoundTrip) {
+  for (const auto* name : BUNDLED_ROMS) {
+    SCOPED_TRACE(name);
+    const auto rom = BundledRom(name);
+    Machine machine;
+    machine.SetQuirks(Quirks::SuperChip);
+    ASSERT_TRUE(machine.Load(rom));
+    RunFrames(machine, 0, FRAMES);
+
+    std::vector<uint8_t> record(SAVESTATE_SIZE);
+    WriteSaveState(machine, rom.Hash(), FRAMES, record.data());
+    Machine loaded;
+    ASSERT_TRUE(loaded.Load(rom));
+    uint64_t frame = 0;
+    ASSERT_TRUE(ReadSaveState(record.data(), rom.Hash(), loaded, frame));
+    EXPECT_EQ(frame, static_cast<uint64_t>(FRAMES));
+    EXPECT_EQ(loaded.GetQuirks(), Quirks::SuperChip);
+    ASSERT_EQ(State(loaded), State(machine));
+
+    /* The keypad is not saved, so both go on from a fresh one */
+    machine.input.Reset();
+    RunFrames(machine, FRAMES, FRAMES);
+    RunFrames(loaded, FRAMES, FRAMES);
+    ASSERT_EQ(State(loaded), State(machine));
+  }
+}
+
+/* A record for another ROM, or with any byte damaged, is refused and
+ * leaves the machine as it was
+ */
+TEST(SaveStateTest, RejectsForeignAndDamagedRecords) {
+  const auto rom = BundledRom("brix.ch8");
+  Machine machine;
+  ASSERT_TRUE(machine.Load(rom));
+  RunFrames(machine, 0, FRAMES);
+  std::vector<uint8_t> record(SAVESTATE_SIZE);
+  WriteSaveState(machine, rom.Hash(), FRAMES, record.data());
+
+  Machine other;
+  ASSERT_TRUE(other.Load(rom));
+  const auto before = State(other);
+  uint64_t frame = 0;
+  EXPECT_FALSE(ReadSaveState(record.data(), rom.Hash() + 1, other, frame));
+  for (const size_t offset : {size_t{0}, size_t{4}, size_t{8},
+                              size_t{SAVESTATE_HEADER_SIZE + 600},
+                              size_t{SAVESTATE_SIZE - 1}}) {
+    auto damaged = record;
+    damaged[offset] ^= 0x01;
+    EXPECT_FALSE(ReadSaveState(damaged.data(), rom.Hash(), other, frame))
+        << "byte " << offset;
+  }
+  EXPECT_EQ(State(other), before);
+}
+
+TEST(SaveStateTest, FileRoundTrip) {
+  const auto rom = BundledRom("tetris.ch8");
+  Machine machine;
+  ASSERT_TRUE(machine.Load(rom));
+  RunFrames(machine, 0, FRAMES);
+  const auto filename = testing::TempDir() + "cchip8_savestate_test.c8s";
+  ASSERT_TRUE(SaveStateToFile(filename, machine, rom.Hash()));
+
+  Machine loaded;
+  ASSERT_TRUE(loaded.Load(rom));
+  ASSERT_TRUE(LoadStateFromFile(filename, rom.Hash(), loaded));
+  EXPECT_EQ(State(loaded), State(machine));
+  std::remove(filename.c_str());
+}
+
+/* The autosave file alternates between two records, and restoring takes
+ * the newer one
+ */
+TEST(SaveStateTest, AutosaveRestoresNewestRecord) {
+  const auto rom = BundledRom("invaders.ch8");
+  const auto filename = testing::TempDir() + "cchip8_autosave_test.c8a";
+  std::remove(filename.c_str());
+  Machine machine;
+  ASSERT_TRUE(machine.Load(rom));
+  {
+    Autosave autosave;
+    ASSERT_TRUE(autosave.Open(filename));
+    for (auto frame = 0; frame < 5; ++frame) {
+      RunFrames(machine, frame, 1);
+      autosave.Write(machine, rom.Hash());
+    }
+  }
+
+  Machine restored;
+  ASSERT_TRUE(restored.Load(rom));
+  Autosave autosave;
+  ASSERT_TRUE(autosave.Open(filename));
+  ASSERT_TRUE(autosave.Restore(rom.Hash(), restored));
+  EXPECT_EQ(State(restored), State(machine));
+  EXPECT_FALSE(autosave.Restore(rom.Hash() + 1, restored));
+  autosave.Close();
+  std::remove(filename.c_str());
+}
+
+}  // namespace
+}  // namespace cchip8::test
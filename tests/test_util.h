@@ -0,0 +1,54 @@
+#ifndef CCHIP8_TESTS_TEST_UTIL_H_
+#define CCHIP8_TESTS_TEST_UTIL_H_
+
+#include <cchip8/machine.h>
+#include <cchip8/quirks.h>
+#include <cchip8/rom.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace cchip8::test {
+
+/* The programs in roms/, which every equivalence test runs */
+inline const std::array<const char*, 7> BUNDLED_ROMS = {
+    "brix.ch8",  "delay_timer_test.ch8", "invaders.ch8", "pong2.ch8",
+    "tank.ch8",  "test_opcode.ch8",      "tetris.ch8",
+};
+
+inline const std::array<Quirks, 3> ALL_QUIRKS = {
+    Quirks::Chip8,
+    Quirks::SuperChip,
+    Quirks::Modern,
+};
+
+inline Rom LoadRom(const std::string& directory, const std::string& name) {
+  Rom rom;
+  EXPECT_TRUE(rom.FromFile(directory + "/" + name)) << name;
+  return rom;
+}
+
+inline Rom BundledRom(const std::string& name) {
+  return LoadRom(CCHIP8_ROM_DIR, name);
+}
+
+/* A keypad that presses one key at a time for a few frames and then lets
+ * go, the same on every run, so that programs waiting on keys get past
+ * their menus
+ */
+inline uint16_t ScriptedKeys(const int frame) {
+  return (frame / 7) % 3 == 0 ? 1u << ((frame / 21) % NUM_KEYS) : 0;
+}
+
+inline std::vector<uint8_t> State(const Machine& machine) {
+  std::vector<uint8_t> state(Machine::STATE_SIZE);
+  machine.SaveState(state.data());
+  return state;
+}
+
+}  // namespace cchip8::test
+
+#endif  // CCHIP8_TESTS_TEST_UTIL_H_
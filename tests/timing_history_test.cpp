@@ -0,0 +1,36 @@
+#include <cchip8/timing_history.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+namespace cchip8::test {
+namespace {
+
+TEST(TimingHistoryTest, EmptyHistoryReportsZero) {
+  const TimingHistory history(8);
+  EXPECT_EQ(history.Percentile(50), 0.0);
+}
+
+/* 1 to 100 ms, so the p-th percentile is p ms */
+TEST(TimingHistoryTest, PercentilesInMilliseconds) {
+  TimingHistory history(100);
+  for (uint64_t ms = 100; ms >= 1; --ms) history.Record(ms * 1000000);
+  EXPECT_EQ(history.Percentile(0), 1.0);
+  EXPECT_EQ(history.Percentile(50), 50.0);
+  EXPECT_EQ(history.Percentile(99), 99.0);
+  EXPECT_EQ(history.Percentile(100), 100.0);
+}
+
+/* Past its capacity, the history only holds the latest durations */
+TEST(TimingHistoryTest, ForgetsTheOldestDurations) {
+  TimingHistory history(4);
+  for (auto i = 0; i < 4; ++i) history.Record(1000000000);
+  for (auto i = 0; i < 4; ++i) history.Record(2000000);
+  EXPECT_EQ(history.Percentile(100), 2.0);
+  history.Record(3000000);
+  EXPECT_EQ(history.Percentile(100), 3.0);
+  EXPECT_EQ(history.Percentile(0), 2.0);
+}
+
+}  // namespace
+}  // namespace cchip8::test